@@ -0,0 +1,323 @@
+#pragma once
+#include <densitas/all.hpp>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+#include <memory>
+#include <algorithm>
+
+
+namespace bench {
+
+
+/**
+ * A row-major matrix backed by a std::vector
+ */
+template<typename ElementType>
+class basic_matrix {
+public:
+
+    basic_matrix()
+        : n_rows_(0), n_cols_(0), data_()
+    {}
+
+    basic_matrix(std::size_t n_rows, std::size_t n_cols)
+        : n_rows_(n_rows), n_cols_(n_cols), data_(n_rows * n_cols)
+    {}
+
+    std::size_t n_rows() const
+    {
+        return n_rows_;
+    }
+
+    std::size_t n_cols() const
+    {
+        return n_cols_;
+    }
+
+    ElementType operator()(std::size_t i, std::size_t j) const
+    {
+        return data_[i * n_cols_ + j];
+    }
+
+    ElementType& operator()(std::size_t i, std::size_t j)
+    {
+        return data_[i * n_cols_ + j];
+    }
+
+    const ElementType* data() const
+    {
+        return data_.data();
+    }
+
+    ElementType* data()
+    {
+        return data_.data();
+    }
+
+private:
+    std::size_t n_rows_;
+    std::size_t n_cols_;
+    std::vector<ElementType> data_;
+};
+
+
+typedef std::vector<double> vector;
+
+typedef bench::basic_matrix<double> matrix;
+
+typedef std::vector<float> float_vector;
+
+typedef bench::basic_matrix<float> float_matrix;
+
+
+/**
+ * A Gaussian naive Bayes classifier used as a lightweight reference model
+ */
+class naive_bayes {
+public:
+
+    naive_bayes()
+        : log_prior_yes_(0), log_prior_no_(0), mean_yes_(), mean_no_(), variance_yes_(), variance_no_()
+    {}
+
+    std::unique_ptr<naive_bayes> clone() const
+    {
+        return std::unique_ptr<naive_bayes>(new naive_bayes(*this));
+    }
+
+    void train(const bench::matrix& X, bench::vector& y)
+    {
+        const auto n_cols = X.n_cols();
+        const auto yes = static_cast<double>(densitas::model_adapter::yes<naive_bayes>());
+        mean_yes_.assign(n_cols, 0.);
+        mean_no_.assign(n_cols, 0.);
+        variance_yes_.assign(n_cols, 0.);
+        variance_no_.assign(n_cols, 0.);
+        std::size_t n_yes = 0;
+        for (std::size_t i=0; i<X.n_rows(); ++i) {
+            const bool is_yes = y[i] == yes;
+            n_yes += is_yes;
+            auto& mean = is_yes ? mean_yes_ : mean_no_;
+            for (std::size_t j=0; j<n_cols; ++j) {
+                mean[j] += X(i, j);
+            }
+        }
+        const auto n_no = X.n_rows() - n_yes;
+        for (std::size_t j=0; j<n_cols; ++j) {
+            mean_yes_[j] /= std::max<std::size_t>(n_yes, 1);
+            mean_no_[j] /= std::max<std::size_t>(n_no, 1);
+        }
+        for (std::size_t i=0; i<X.n_rows(); ++i) {
+            const bool is_yes = y[i] == yes;
+            const auto& mean = is_yes ? mean_yes_ : mean_no_;
+            auto& variance = is_yes ? variance_yes_ : variance_no_;
+            for (std::size_t j=0; j<n_cols; ++j) {
+                const auto diff = X(i, j) - mean[j];
+                variance[j] += diff * diff;
+            }
+        }
+        for (std::size_t j=0; j<n_cols; ++j) {
+            variance_yes_[j] = variance_yes_[j] / std::max<std::size_t>(n_yes, 1) + 1e-9;
+            variance_no_[j] = variance_no_[j] / std::max<std::size_t>(n_no, 1) + 1e-9;
+        }
+        log_prior_yes_ = std::log((n_yes + 1.) / (X.n_rows() + 2.));
+        log_prior_no_ = std::log((n_no + 1.) / (X.n_rows() + 2.));
+    }
+
+    bench::vector predict_proba(bench::matrix& X) const
+    {
+        bench::vector probas(X.n_rows());
+        for (std::size_t i=0; i<X.n_rows(); ++i) {
+            auto log_yes = log_prior_yes_;
+            auto log_no = log_prior_no_;
+            for (std::size_t j=0; j<X.n_cols(); ++j) {
+                log_yes += log_likelihood(X(i, j), mean_yes_[j], variance_yes_[j]);
+                log_no += log_likelihood(X(i, j), mean_no_[j], variance_no_[j]);
+            }
+            probas[i] = 1. / (1. + std::exp(log_no - log_yes));
+        }
+        return probas;
+    }
+
+private:
+
+    static double log_likelihood(double value, double mean, double variance)
+    {
+        const auto diff = value - mean;
+        return -0.5 * (std::log(variance) + diff * diff / variance);
+    }
+
+    double log_prior_yes_;
+    double log_prior_no_;
+    std::vector<double> mean_yes_;
+    std::vector<double> mean_no_;
+    std::vector<double> variance_yes_;
+    std::vector<double> variance_no_;
+};
+
+
+/**
+ * Synthetic regression data: normally distributed features and a target
+ * which is a weighted sum of the features plus noise. Always generates the
+ * same data for the same arguments
+ */
+inline
+void make_data(std::size_t n_rows, std::size_t n_features, bench::matrix& X, bench::vector& y)
+{
+    std::mt19937_64 engine(42);
+    std::normal_distribution<double> normal(0., 1.);
+    X = bench::matrix(n_rows, n_features);
+    y.assign(n_rows, 0.);
+    for (std::size_t i=0; i<n_rows; ++i) {
+        for (std::size_t j=0; j<n_features; ++j) {
+            X(i, j) = normal(engine);
+            y[i] += X(i, j) / (j + 1.);
+        }
+        y[i] += 0.5 * normal(engine);
+    }
+}
+
+
+/**
+ * Returns n values drawn uniformly from [0, 1). Always returns the same
+ * values for the same arguments
+ */
+template<typename VectorType>
+VectorType make_uniform(std::size_t n, unsigned seed=42)
+{
+    std::mt19937_64 engine(seed);
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    VectorType values(n);
+    for (auto& value : values) {
+        value = static_cast<typename VectorType::value_type>(uniform(engine));
+    }
+    return values;
+}
+
+
+/**
+ * Returns the seconds elapsed since start
+ */
+inline
+double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+/**
+ * Returns the median of the values
+ */
+inline
+double median(std::vector<double> values)
+{
+    if (values.empty())
+        return 0.;
+    std::sort(values.begin(), values.end());
+    const auto n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+
+/**
+ * Parses a comma-separated list of positive integers such as "1,2,4"
+ */
+inline
+std::vector<std::size_t> parse_list(const std::string& text)
+{
+    std::vector<std::size_t> values;
+    std::istringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        char* end = nullptr;
+        const auto value = std::strtoul(item.c_str(), &end, 10);
+        if (item.empty() || *end != '\0' || value == 0)
+            throw densitas::densitas_error("not a list of positive integers: " + text);
+        values.push_back(value);
+    }
+    if (values.empty())
+        throw densitas::densitas_error("empty list");
+    return values;
+}
+
+
+} // bench
+
+
+namespace densitas {
+namespace vector_adapter {
+
+template<>
+inline
+double get_element<double, bench::vector>(const bench::vector& vector, std::size_t index)
+{
+    return vector[index];
+}
+
+template<>
+inline
+void set_element<double, bench::vector>(bench::vector& vector, std::size_t index, double value)
+{
+    vector[index] = value;
+}
+
+template<>
+inline
+float get_element<float, bench::float_vector>(const bench::float_vector& vector, std::size_t index)
+{
+    return vector[index];
+}
+
+template<>
+inline
+void set_element<float, bench::float_vector>(bench::float_vector& vector, std::size_t index, float value)
+{
+    vector[index] = value;
+}
+
+template<>
+struct contiguous_memory<bench::vector> : std::true_type {};
+
+template<>
+struct contiguous_memory<bench::float_vector> : std::true_type {};
+
+} // vector_adapter
+
+
+namespace matrix_adapter {
+
+template<>
+inline
+densitas::matrix_adapter::memory_layout<const double> layout<double, bench::matrix>(const bench::matrix& matrix)
+{
+    return densitas::matrix_adapter::memory_layout<const double>{matrix.data(), matrix.n_cols(), 1};
+}
+
+template<>
+inline
+densitas::matrix_adapter::memory_layout<double> mutable_layout<double, bench::matrix>(bench::matrix& matrix)
+{
+    return densitas::matrix_adapter::memory_layout<double>{matrix.data(), matrix.n_cols(), 1};
+}
+
+template<>
+inline
+densitas::matrix_adapter::memory_layout<const float> layout<float, bench::float_matrix>(const bench::float_matrix& matrix)
+{
+    return densitas::matrix_adapter::memory_layout<const float>{matrix.data(), matrix.n_cols(), 1};
+}
+
+template<>
+inline
+densitas::matrix_adapter::memory_layout<float> mutable_layout<float, bench::float_matrix>(bench::float_matrix& matrix)
+{
+    return densitas::matrix_adapter::memory_layout<float>{matrix.data(), matrix.n_cols(), 1};
+}
+
+} // matrix_adapter
+} // densitas
@@ -0,0 +1,172 @@
+// End-to-end benchmark of density_estimator::train and predict over the
+// number of events, features, models and threads. Run it with 'make bench',
+// passing options via BENCH_ARGS, e.g.
+//   make bench BENCH_ARGS="--rows 10000,100000 --threads 1,4"
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+#include <thread>
+
+
+namespace {
+
+
+struct estimator_t : densitas::density_estimator<estimator_t, bench::naive_bayes, bench::matrix, bench::vector> {
+
+    estimator_t()
+    : density_estimator_type{}, binning_done_{}, binned_{false}
+    {}
+
+    estimator_t(const bench::naive_bayes& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}, binning_done_{}, binned_{false}
+    {}
+
+    // the time at which the binning phase ended and the models started training
+    std::chrono::steady_clock::time_point binning_done() const
+    {
+        return binning_done_;
+    }
+
+protected:
+
+    virtual void on_train_status(const bench::naive_bayes&, std::size_t, const bench::matrix&, const train_params&) const
+    {
+        if (!binned_) {
+            binning_done_ = std::chrono::steady_clock::now();
+            binned_ = true;
+        }
+    }
+
+private:
+    mutable std::chrono::steady_clock::time_point binning_done_;
+    mutable bool binned_;
+};
+
+
+struct options {
+    std::vector<std::size_t> rows;
+    std::vector<std::size_t> features;
+    std::vector<std::size_t> models;
+    std::vector<std::size_t> threads;
+    std::size_t repeat;
+};
+
+
+std::vector<std::size_t> default_threads()
+{
+    const auto max_threads = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    std::vector<std::size_t> threads;
+    for (std::size_t n=1; n<max_threads; n*=2) {
+        threads.push_back(n);
+    }
+    threads.push_back(max_threads);
+    return threads;
+}
+
+
+void print_usage()
+{
+    std::cout << "usage: benchmark [--rows LIST] [--features LIST] [--models LIST] [--threads LIST] [--repeat N]\n"
+              << "  LIST is a comma-separated list of positive integers\n"
+              << "  defaults: --rows 100000 --features 10 --models 10 --threads 1,2,4,..,n_cores --repeat 3" << std::endl;
+}
+
+
+options parse_options(int argc, char** argv)
+{
+    options opts = {{100000}, {10}, {10}, default_threads(), 3};
+    for (int i=1; i<argc; ++i) {
+        const std::string name = argv[i];
+        if (name == "--help" || name == "-h") {
+            print_usage();
+            std::exit(0);
+        }
+        if (i + 1 == argc)
+            throw densitas::densitas_error("missing value for option: " + name);
+        const auto values = bench::parse_list(argv[++i]);
+        if (name == "--rows")
+            opts.rows = values;
+        else if (name == "--features")
+            opts.features = values;
+        else if (name == "--models")
+            opts.models = values;
+        else if (name == "--threads")
+            opts.threads = values;
+        else if (name == "--repeat")
+            opts.repeat = values.front();
+        else
+            throw densitas::densitas_error("unknown option: " + name);
+    }
+    return opts;
+}
+
+
+struct timings {
+    double binning;
+    double fitting;
+    double train;
+    double predict;
+};
+
+
+timings run(const bench::matrix& X, const bench::vector& y, std::size_t n_models, int threads, std::size_t repeat)
+{
+    std::vector<double> binning, fitting, train, predict;
+    for (std::size_t r=0; r<repeat; ++r) {
+        estimator_t estimator(bench::naive_bayes(), n_models);
+        auto start = std::chrono::steady_clock::now();
+        estimator.train(X, y, threads);
+        train.push_back(bench::seconds_since(start));
+        binning.push_back(std::chrono::duration<double>(estimator.binning_done() - start).count());
+        fitting.push_back(train.back() - binning.back());
+        start = std::chrono::steady_clock::now();
+        const auto prediction = estimator.predict(X, threads);
+        predict.push_back(bench::seconds_since(start));
+        if (prediction.n_rows() != X.n_rows())
+            throw densitas::densitas_error("unexpected number of predicted events");
+    }
+    return timings{bench::median(binning), bench::median(fitting), bench::median(train), bench::median(predict)};
+}
+
+
+} // anonymous
+
+
+int main(int argc, char** argv)
+{
+    try {
+        const auto opts = parse_options(argc, argv);
+        std::cout << "densitas " << densitas::version() << " benchmark, median of " << opts.repeat << " runs, times in seconds" << std::endl;
+        std::cout << std::setw(9) << "rows" << std::setw(9) << "features" << std::setw(7) << "models" << std::setw(8) << "threads"
+                  << std::setw(10) << "binning" << std::setw(10) << "fitting" << std::setw(10) << "train" << std::setw(13) << "train_rows/s" << std::setw(9) << "speedup"
+                  << std::setw(10) << "predict" << std::setw(15) << "predict_rows/s" << std::setw(9) << "speedup" << std::endl;
+        std::cout << std::fixed;
+        for (auto n_rows : opts.rows) {
+            for (auto n_features : opts.features) {
+                bench::matrix X;
+                bench::vector y;
+                bench::make_data(n_rows, n_features, X, y);
+                for (auto n_models : opts.models) {
+                    timings baseline = {};
+                    for (auto threads : opts.threads) {
+                        const auto t = run(X, y, n_models, static_cast<int>(threads), opts.repeat);
+                        if (threads == opts.threads.front())
+                            baseline = t;
+                        std::cout << std::setw(9) << n_rows << std::setw(9) << n_features << std::setw(7) << n_models << std::setw(8) << threads
+                                  << std::setprecision(4) << std::setw(10) << t.binning << std::setw(10) << t.fitting << std::setw(10) << t.train
+                                  << std::setprecision(0) << std::setw(13) << n_rows / t.train
+                                  << std::setprecision(2) << std::setw(9) << baseline.train / t.train
+                                  << std::setprecision(4) << std::setw(10) << t.predict
+                                  << std::setprecision(0) << std::setw(15) << n_rows / t.predict
+                                  << std::setprecision(2) << std::setw(9) << baseline.predict / t.predict << std::endl;
+                    }
+                }
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        print_usage();
+        return 1;
+    }
+    return 0;
+}
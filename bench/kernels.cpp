@@ -0,0 +1,213 @@
+// Microbenchmarks of the kernels in math.hpp and manipulation.hpp over the
+// number of elements and the element type. Run it with 'make bench-kernels',
+// passing options via BENCH_ARGS, e.g.
+//   make bench-kernels BENCH_ARGS="--sizes 100 --quantiles 10 --filter quantiles"
+#include "bench.hpp"
+#include <iostream>
+#include <iomanip>
+
+
+namespace {
+
+
+// results are added to it so that the kernels are not optimized away
+volatile double sink = 0;
+
+
+// a model predicting a constant probability so that predict_proba_for_row
+// measures the overhead of densitas only
+template<typename VectorType, typename MatrixType>
+struct constant_model {
+    VectorType predict_proba(MatrixType& X) const
+    {
+        return VectorType(X.n_rows(), 0.5);
+    }
+};
+
+
+std::string instruction_set_name(densitas::simd::instruction_set set)
+{
+    switch (set) {
+    case densitas::simd::instruction_set::sse2: return "sse2";
+    case densitas::simd::instruction_set::avx2: return "avx2";
+    case densitas::simd::instruction_set::avx512: return "avx512";
+    default: return "scalar";
+    }
+}
+
+
+struct options {
+    std::vector<std::size_t> sizes;
+    std::size_t n_quantiles;
+    std::size_t min_time_ms;
+    std::string filter;
+};
+
+
+void print_usage()
+{
+    std::cout << "usage: kernels [--sizes LIST] [--quantiles N] [--min-time-ms N] [--filter NAME]\n"
+              << "  LIST is a comma-separated list of positive integers\n"
+              << "  only kernels whose name contains NAME are run\n"
+              << "  defaults: --sizes 10,100,1000,100000 --quantiles 10 --min-time-ms 100" << std::endl;
+}
+
+
+options parse_options(int argc, char** argv)
+{
+    options opts = {{10, 100, 1000, 100000}, 10, 100, ""};
+    for (int i=1; i<argc; ++i) {
+        const std::string name = argv[i];
+        if (name == "--help" || name == "-h") {
+            print_usage();
+            std::exit(0);
+        }
+        if (i + 1 == argc)
+            throw densitas::densitas_error("missing value for option: " + name);
+        const std::string value = argv[++i];
+        if (name == "--sizes")
+            opts.sizes = bench::parse_list(value);
+        else if (name == "--quantiles")
+            opts.n_quantiles = bench::parse_list(value).front();
+        else if (name == "--min-time-ms")
+            opts.min_time_ms = bench::parse_list(value).front();
+        else if (name == "--filter")
+            opts.filter = value;
+        else
+            throw densitas::densitas_error("unknown option: " + name);
+    }
+    return opts;
+}
+
+
+// calls the functor with doubling repetitions until they take at least
+// min_seconds and returns the seconds per call
+template<typename Functor>
+double seconds_per_call(Functor&& functor, double min_seconds)
+{
+    functor();
+    for (std::size_t n_calls=1;; n_calls*=2) {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t i=0; i<n_calls; ++i) {
+            functor();
+        }
+        const auto elapsed = bench::seconds_since(start);
+        if (elapsed >= min_seconds)
+            return elapsed / n_calls;
+    }
+}
+
+
+template<typename ElementType, typename VectorType, typename MatrixType>
+class kernel_runner {
+public:
+
+    kernel_runner(const std::string& type_name, const options& opts)
+        : type_name_(type_name), opts_(opts)
+    {}
+
+    void run(std::size_t n) const
+    {
+        typedef constant_model<VectorType, MatrixType> model_type;
+        const auto data = bench::make_uniform<VectorType>(n);
+        auto sorted = data;
+        std::sort(sorted.begin(), sorted.end());
+        const auto weights = bench::make_uniform<VectorType>(n, 7);
+        const auto probas = probabilities();
+        const auto edges = densitas::math::quantiles<ElementType>(data, densitas::math::linspace<VectorType, ElementType>(0, 1, opts_.n_quantiles + 1));
+        const std::string n_probas = "n_probas=" + std::to_string(opts_.n_quantiles);
+
+        measure("quantile", n, "incl. copy", [&]() {
+            auto copy = data;
+            sink = sink + densitas::math::quantile<ElementType>(copy, static_cast<ElementType>(0.5));
+        });
+        measure("quantiles", n, n_probas, [&]() {
+            sink = sink + densitas::math::quantiles<ElementType>(data, probas)[0];
+        });
+        for (double accuracy : {1e-1, 1e-2, 1e-3}) {
+            std::ostringstream param;
+            param << n_probas << " accuracy=" << accuracy;
+            measure("quantiles_weighted", n, param.str(), [&]() {
+                sink = sink + densitas::math::quantiles_weighted<ElementType>(sorted, weights, probas, static_cast<ElementType>(accuracy))[0];
+            });
+        }
+        measure("quantiles_weighted_exact", n, n_probas, [&]() {
+            sink = sink + densitas::math::quantiles_weighted_exact<ElementType>(sorted, weights, probas)[0];
+        });
+        measure("centers", n, "n_bins=" + std::to_string(opts_.n_quantiles), [&]() {
+            sink = sink + densitas::math::centers<ElementType>(data, edges)[0];
+        });
+        measure("make_classification_target", n, "", [&]() {
+            const auto target = densitas::math::make_classification_target<model_type, ElementType>(data, static_cast<ElementType>(0.25), static_cast<ElementType>(0.75));
+            sink = sink + target[0];
+        });
+
+        auto matrix = densitas::matrix_adapter::construct_uninitialized<MatrixType>(4, n);
+        densitas::core::assign_vector_to_row<ElementType>(matrix, 1, data);
+        measure("extract_row", n, "n=columns", [&]() {
+            sink = sink + densitas::core::extract_row<ElementType, VectorType>(matrix, 1)[0];
+        });
+        measure("assign_vector_to_row", n, "n=columns", [&]() {
+            densitas::core::assign_vector_to_row<ElementType>(matrix, 2, data);
+            sink = sink + matrix(2, 0);
+        });
+        const model_type model = {};
+        measure("predict_proba_for_row", n, "n=columns", [&]() {
+            sink = sink + densitas::core::predict_proba_for_row<ElementType, VectorType>(model, matrix, 1);
+        });
+    }
+
+private:
+
+    VectorType probabilities() const
+    {
+        VectorType probas(opts_.n_quantiles);
+        for (std::size_t i=0; i<probas.size(); ++i) {
+            probas[i] = static_cast<ElementType>((i + 1.) / (probas.size() + 1.));
+        }
+        return probas;
+    }
+
+    template<typename Functor>
+    void measure(const std::string& name, std::size_t n, const std::string& param, Functor&& functor) const
+    {
+        if (name.find(opts_.filter) == std::string::npos)
+            return;
+        const auto seconds = seconds_per_call(functor, opts_.min_time_ms / 1000.);
+        std::cout << std::left << std::setw(28) << name << std::setw(8) << type_name_ << std::right << std::setw(9) << n
+                  << "  " << std::left << std::setw(30) << param << std::right
+                  << std::setprecision(1) << std::setw(14) << seconds * 1e9
+                  << std::setprecision(2) << std::setw(12) << n / seconds / 1e6 << std::endl;
+    }
+
+    std::string type_name_;
+    const options& opts_;
+};
+
+
+} // anonymous
+
+
+int main(int argc, char** argv)
+{
+    try {
+        const auto opts = parse_options(argc, argv);
+        std::cout << "densitas " << densitas::version() << " kernel benchmark, simd: "
+                  << instruction_set_name(densitas::simd::active_instruction_set()) << std::endl;
+        std::cout << std::left << std::setw(28) << "kernel" << std::setw(8) << "type" << std::right << std::setw(9) << "n"
+                  << "  " << std::left << std::setw(30) << "parameters" << std::right
+                  << std::setw(14) << "ns/call" << std::setw(12) << "Melem/s" << std::endl;
+        std::cout << std::fixed;
+        const kernel_runner<double, bench::vector, bench::matrix> double_runner("double", opts);
+        const kernel_runner<float, bench::float_vector, bench::float_matrix> float_runner("float", opts);
+        for (auto n : opts.sizes) {
+            double_runner.run(n);
+            float_runner.run(n);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        print_usage();
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+#include "densitas/cancellation.hpp"
+
+
+namespace densitas {
+
+
+cancellation_token::cancellation_token()
+: cancelled_{false}, has_deadline_{false}, deadline_{}
+{}
+
+cancellation_token::cancellation_token(std::chrono::steady_clock::time_point deadline)
+: cancelled_{false}, has_deadline_{true}, deadline_{deadline}
+{}
+
+cancellation_token::~cancellation_token()
+{}
+
+void cancellation_token::cancel()
+{
+    cancelled_ = true;
+}
+
+bool cancellation_token::is_cancelled() const
+{
+    if (cancelled_)
+        return true;
+    // remembered so that later checks do not need to read the clock
+    if (has_deadline_ && !(std::chrono::steady_clock::now() < deadline_))
+        cancelled_ = true;
+    return cancelled_;
+}
+
+
+} // densitas
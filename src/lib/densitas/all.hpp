@@ -1,5 +1,6 @@
 #pragma once
 #include "density_estimator.hpp"
+#include "fixed_density_estimator.hpp"
 #include "densitas_error.hpp"
 #include "math.hpp"
 #include "model_adapter.hpp"
@@ -7,5 +8,10 @@
 #include "vector_adapter.hpp"
 #include "manipulation.hpp"
 #include "task_manager.hpp"
+#include "simd.hpp"
+#include "metrics.hpp"
+#include "tracer.hpp"
+#include "cancellation.hpp"
+#include "serialization.hpp"
 #include "type_check.hpp"
 #include "version.hpp"
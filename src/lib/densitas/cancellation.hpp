@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+
+
+namespace densitas {
+
+
+/**
+ * Cooperatively cancels training or predicting, either explicitly via
+ * cancel() or once a deadline has passed. Cancellation is only checked
+ * between events and models, so work in progress is always finished.
+ * All methods are thread-safe
+ */
+class cancellation_token {
+public:
+
+    cancellation_token();
+
+    /**
+     * Constructs a token that is cancelled once the deadline has passed
+     */
+    explicit
+    cancellation_token(std::chrono::steady_clock::time_point deadline);
+
+    virtual ~cancellation_token();
+
+    void cancel();
+
+    bool is_cancelled() const;
+
+    cancellation_token(const cancellation_token&) = delete;
+    cancellation_token& operator=(const cancellation_token&) = delete;
+    cancellation_token(cancellation_token&&) = delete;
+    cancellation_token& operator=(cancellation_token&&) = delete;
+
+protected:
+    mutable std::atomic_bool cancelled_;
+    const bool has_deadline_;
+    const std::chrono::steady_clock::time_point deadline_;
+};
+
+
+} // densitas
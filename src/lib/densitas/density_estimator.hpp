@@ -6,7 +6,22 @@
 #include "vector_adapter.hpp"
 #include "manipulation.hpp"
 #include "task_manager.hpp"
+#include "serialization.hpp"
+#include "metrics.hpp"
+#include "tracer.hpp"
+#include "cancellation.hpp"
+#include "densitas_error.hpp"
 #include <vector>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <memory>
+#include <cstdint>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <exception>
 
 
 namespace densitas {
@@ -40,6 +55,20 @@ public:
     typedef VectorType vector_type;
     typedef ElementType element_type;
 
+    /**
+     * The scratch state of predicting events, reused between calls and
+     *  events. Use one workspace per thread
+     */
+    struct predict_workspace {
+        matrix_type features;
+        matrix_type batch_weights;
+        vector_type weights;
+        vector_type probas;
+        vector_type quantiles;
+        vector_type cdf;
+        densitas::math::scratch_buffers<element_type> scratch;
+    };
+
     /**
      * Returns a clone of this density estimator
      */
@@ -50,8 +79,17 @@ public:
             estimator->models_.emplace_back(densitas::model_adapter::clone(*model));
         }
         estimator->trained_centers_ = trained_centers_;
+        estimator->trained_quantiles_ = trained_quantiles_;
+        estimator->bin_sums_ = bin_sums_;
+        estimator->bin_counts_ = bin_counts_;
         estimator->predicted_quantiles_ = predicted_quantiles_;
         estimator->accuracy_predicted_quantiles_ = accuracy_predicted_quantiles_;
+        estimator->exact_predicted_quantiles_ = exact_predicted_quantiles_;
+        estimator->predict_batch_size_ = predict_batch_size_;
+        estimator->predict_status_ = predict_status_;
+        estimator->mapping_ = mapping_;
+        estimator->metrics_ = metrics_;
+        estimator->tracer_ = tracer_;
         return std::move(estimator);
     }
 
@@ -76,6 +114,7 @@ public:
      */
     void predicted_quantiles(const vector_type& quantiles)
     {
+        check_n_predicted_quantiles(densitas::vector_adapter::n_elements(quantiles));
         predicted_quantiles_ = quantiles;
     }
 
@@ -90,6 +129,56 @@ public:
         accuracy_predicted_quantiles_ = accuracy;
     }
 
+    /**
+     * Sets whether the predicted quantiles are computed exactly from the
+     *  cumulative model weights or by replicating the trained centers
+     *  according to the model weights, in which case the accuracy is
+     *  controlled by accuracy_predicted_quantiles. Default: true
+     * @param exact Whether to compute the predicted quantiles exactly
+     */
+    void exact_predicted_quantiles(bool exact)
+    {
+        exact_predicted_quantiles_ = exact;
+    }
+
+    /**
+     * Sets the number of events each model scores in a single call to
+     *  predict_proba. With a batch size larger than one, predict_proba is
+     *  given a matrix of up to that many events and must return one
+     *  probability per event. Default: 1
+     * @param batch_size The number of events scored per call
+     */
+    void predict_batch_size(std::size_t batch_size)
+    {
+        if (!(batch_size > 0))
+            throw densitas::densitas_error("batch size must be larger than zero");
+        predict_batch_size_ = batch_size;
+    }
+
+    /**
+     * Sets the metrics to record the time spent in each phase of training
+     *  and predicting to, see densitas::metrics. Clones record to the same
+     *  metrics. Default: nullptr, i.e. no metrics are recorded
+     * @param recorder The metrics to record to or nullptr
+     */
+    void metrics(std::shared_ptr<densitas::metrics> recorder)
+    {
+        metrics_ = std::move(recorder);
+    }
+
+    /**
+     * Sets the tracer to record the tasks run while training and predicting
+     *  to, see densitas::tracer. Events are recorded for every call, every
+     *  model trained, every range of events predicted and every wait for a
+     *  free thread or for the sink of predict_stream. Clones record to the
+     *  same tracer. Default: nullptr, i.e. nothing is traced
+     * @param recorder The tracer to record to or nullptr
+     */
+    void tracer(std::shared_ptr<densitas::tracer> recorder)
+    {
+        tracer_ = std::move(recorder);
+    }
+
     /**
      * Trains the density estimator
      * @param X A matrix of shape (n_events, n_features)
@@ -98,53 +187,434 @@ public:
      */
     void train(const matrix_type& X, const vector_type& y, int threads=1)
     {
-        check_n_models(models_.size());
-        const auto quantiles = densitas::math::linspace<vector_type, element_type>(0, 1, models_.size() + 1);
-        const auto trained_quantiles = densitas::math::quantiles<element_type>(y, quantiles);
-        trained_centers_ = densitas::math::centers<element_type>(y, trained_quantiles);
-        const auto params = train_params{y, trained_quantiles};
-        if (threads > 1) {
-            densitas::core::task_manager manager(threads);
-            for (std::size_t i=0; i<models_.size(); ++i) {
-                manager.wait_for_slot();
-                on_train_status(*models_[i], i, X, params);
-                manager.launch_new(density_estimator::train_model, std::ref(*models_[i]), i, X, std::ref(params));
-            }
-        } else {
-            for (std::size_t i=0; i<models_.size(); ++i) {
-                on_train_status(*models_[i], i, X, params);
-                density_estimator::train_model(*models_[i], i, X, params);
-            }
-        }
+        train_until(X, y, nullptr, threads);
     }
 
     /**
-     * Predicts events using this trained density estimator
+     * Trains the density estimator unless cancelled. Once the token is
+     *  cancelled no further models are started, models being trained are
+     *  finished and their results discarded. The models are trained as
+     *  clones so that this density estimator is only changed if training
+     *  completes
      * @param X A matrix of shape (n_events, n_features)
+     * @param y A vector of shape (n_events)
+     * @param token The token cancelling the training, e.g. at a deadline
+     * @param threads Max number of threads to launch, single-threaded if <= 1
+     * @return Whether training completed
+     */
+    bool train(const matrix_type& X, const vector_type& y, const densitas::cancellation_token& token, int threads=1)
+    {
+        return train_until(X, y, &token, threads);
+    }
+
+    /**
+     * Trains the density estimator asynchronously on the asynchronous thread
+     *  pool, see train(). X and y are copied. This density estimator must
+     *  outlive the returned future and must not be used until it is ready
+     * @param X A matrix of shape (n_events, n_features)
+     * @param y A vector of shape (n_events)
      * @param threads Max number of threads to launch, single-threaded if <= 1
+     * @return A future that is ready once training completed
+     */
+    std::future<void> train_async(const matrix_type& X, const vector_type& y, int threads=1)
+    {
+        return train_async(densitas::core::async_thread_pool(), X, y, threads);
+    }
+
+    /**
+     * Trains the density estimator asynchronously on the given executor,
+     *  see train_async(X, y, threads)
+     * @param executor The thread pool to run on. Must not be the default thread pool
+     * @param X A matrix of shape (n_events, n_features)
+     * @param y A vector of shape (n_events)
+     * @param threads Max number of threads to launch, single-threaded if <= 1
+     * @return A future that is ready once training completed
+     */
+    std::future<void> train_async(densitas::core::thread_pool& executor, const matrix_type& X, const vector_type& y, int threads=1)
+    {
+        return densitas::core::launch_async(executor, [this, X, y, threads]() {
+            this->train(X, y, threads);
+        });
+    }
+
+    /**
+     * Updates the trained density estimator with additional events only.
+     *  The bin edges found by train() are kept fixed, events outside of them
+     *  fall into the first or last bin. The trained centers become the means
+     *  of all events seen so far and every model is updated using
+     *  model_adapter::partial_train
+     * @param X A matrix of shape (n_events, n_features)
+     * @param y A vector of shape (n_events)
+     * @param threads Max number of threads to launch, single-threaded if <= 1
+     */
+    void partial_train(const matrix_type& X, const vector_type& y, int threads=1)
+    {
+        const densitas::core::trace_scope trace{tracer_.get(), "partial_train", "train", {{"n_models", models_.size()}, {"threads", static_cast<std::size_t>(threads > 1 ? threads : 1)}}};
+        check_n_models(models_.size());
+        if (densitas::vector_adapter::n_elements(trained_quantiles_) != models_.size() + 1 || bin_sums_.size() != models_.size())
+            throw densitas::densitas_error("density estimator must be trained before partial training");
+        if (!(densitas::vector_adapter::n_elements(y) > 0))
+            throw densitas::densitas_error("size of y is zero");
+        if (!densitas::model_adapter::supports_partial_train<model_type, matrix_type, vector_type>::value)
+            throw densitas::densitas_error("model does not support partial training");
+        const auto metrics = metrics_.get();
+        const densitas::core::stopwatch centers_watch{metrics != nullptr};
+        const auto bins = densitas::math::bin_ranges<element_type>(y, trained_quantiles_);
+        auto bin_sums = bin_sums_;
+        auto bin_counts = bin_counts_;
+        densitas::math::accumulate_bins<element_type>(y, bins, bin_sums, bin_counts, threads);
+        auto centers = densitas::math::make_centers<element_type, vector_type>(bin_sums, bin_counts);
+        density_estimator::record(metrics, densitas::metrics::phase::centers, centers_watch);
+        const auto params = train_params{y, trained_quantiles_, bins, true, metrics, tracer_.get(), nullptr, nullptr};
+        train_models(models_, X, params, threads);
+        trained_centers_ = std::move(centers);
+        bin_sums_ = std::move(bin_sums);
+        bin_counts_ = std::move(bin_counts);
+    }
+
+    /**
+     * Predicts events using this trained density estimator. When multi-threaded,
+     *  the calling thread and the workers pull contiguous ranges of events
+     *  until all events are predicted. Calls to on_predict_status are
+     *  serialized and made in ascending order of the events, each before
+     *  its event is predicted, but not necessarily from the calling thread.
+     *  When cancelled, events may have been reported without being predicted
+     * @param X A matrix of shape (n_events, n_features)
+     * @param threads Max number of threads to use, single-threaded if <= 1
      * @return A matrix of shape (n_events, n_predicted_quantiles)
      */
     matrix_type predict(const matrix_type& X, int threads=1) const
+    {
+        return predict_until(X, nullptr, false, nullptr, nullptr, threads);
+    }
+
+    /**
+     * Predicts events using this trained density estimator unless cancelled.
+     *  Once the token is cancelled no further events are started, events
+     *  being predicted are finished. The rows of events not predicted are
+     *  left unspecified
+     * @param X A matrix of shape (n_events, n_features)
+     * @param token The token cancelling the prediction, e.g. at a deadline
+     * @param completed Set to shape (n_events) telling which events are predicted
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A matrix of shape (n_events, n_predicted_quantiles)
+     */
+    matrix_type predict(const matrix_type& X, const densitas::cancellation_token& token, std::vector<bool>& completed, int threads=1) const
+    {
+        std::vector<char> predicted(densitas::matrix_adapter::n_rows(X), 0);
+        auto prediction = predict_until(X, nullptr, false, &token, &predicted, threads);
+        completed.assign(predicted.begin(), predicted.end());
+        return prediction;
+    }
+
+    /**
+     * Predicts the conditional cumulative distribution of events at the
+     *  points of a grid using this trained density estimator. The
+     *  distribution is the one the exact predicted quantiles are taken
+     *  from, it is evaluated from the model weights in a single cumulative
+     *  pass per event. See predict() for threading
+     * @param X A matrix of shape (n_events, n_features)
+     * @param grid The points, sorted in ascending order
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A matrix of shape (n_events, n_points)
+     */
+    matrix_type predict_cdf(const matrix_type& X, const vector_type& grid, int threads=1) const
+    {
+        if (!(densitas::vector_adapter::n_elements(grid) > 0))
+            throw densitas::densitas_error("grid contains no points");
+        if (!densitas::math::is_sorted<element_type>(grid))
+            throw densitas::densitas_error("grid must be sorted in ascending order");
+        return predict_until(X, &grid, false, nullptr, nullptr, threads);
+    }
+
+    /**
+     * Predicts the conditional cumulative distribution of events at the
+     *  bin edges found by train(), see predict_cdf(X, grid, threads)
+     * @param X A matrix of shape (n_events, n_features)
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A matrix of shape (n_events, n_models + 1)
+     */
+    matrix_type predict_cdf(const matrix_type& X, int threads=1) const
+    {
+        check_bin_edges();
+        return predict_until(X, &trained_quantiles_, false, nullptr, nullptr, threads);
+    }
+
+    /**
+     * Predicts the conditional density of events per interval of a grid,
+     *  i.e., the increase of the cumulative distribution across an interval
+     *  divided by its width, see predict_cdf(X, grid, threads)
+     * @param X A matrix of shape (n_events, n_features)
+     * @param grid The points, strictly increasing and at least two
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A matrix of shape (n_events, n_points - 1)
+     */
+    matrix_type predict_density(const matrix_type& X, const vector_type& grid, int threads=1) const
+    {
+        density_estimator::check_intervals(grid, "grid");
+        return predict_until(X, &grid, true, nullptr, nullptr, threads);
+    }
+
+    /**
+     * Predicts the conditional density of events per bin found by train(),
+     *  see predict_density(X, grid, threads). The bin edges must be
+     *  strictly increasing
+     * @param X A matrix of shape (n_events, n_features)
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A matrix of shape (n_events, n_models)
+     */
+    matrix_type predict_density(const matrix_type& X, int threads=1) const
+    {
+        check_bin_edges();
+        density_estimator::check_intervals(trained_quantiles_, "bin edges");
+        return predict_until(X, &trained_quantiles_, true, nullptr, nullptr, threads);
+    }
+
+    /**
+     * Returns a workspace for predict_one that is sized for the current
+     *  models
+     */
+    predict_workspace make_predict_workspace() const
+    {
+        auto workspace = predict_workspace{densitas::matrix_adapter::construct_uninitialized<matrix_type>(0, 0),
+                                           densitas::matrix_adapter::construct_uninitialized<matrix_type>(0, 0),
+                                           densitas::vector_adapter::construct_uninitialized<vector_type>(models_.size()),
+                                           densitas::vector_adapter::construct_uninitialized<vector_type>(1),
+                                           densitas::vector_adapter::construct_uninitialized<vector_type>(0),
+                                           densitas::vector_adapter::construct_uninitialized<vector_type>(0),
+                                           {}};
+        workspace.scratch.order.reserve(models_.size());
+        return workspace;
+    }
+
+    /**
+     * Predicts a single event using this trained density estimator without
+     *  allocating the prediction or any scratch memory once out and the
+     *  workspace are sized, provided model_adapter::predict_proba_into
+     *  reuses the given probabilities. on_predict_status is not called
+     * @param row A matrix of shape (1, n_features) given to the models as is
+     * @param out Set to shape (n_predicted_quantiles), only resized if needed
+     * @param workspace The scratch state, see make_predict_workspace()
+     */
+    void predict_one(matrix_type& row, vector_type& out, predict_workspace& workspace) const
     {
         check_n_models(models_.size());
-        const auto n_rows = densitas::matrix_adapter::n_rows(X);
-        const auto n_quantiles = densitas::vector_adapter::n_elements(predicted_quantiles_);
-        auto prediction = densitas::matrix_adapter::construct_uninitialized<matrix_type>(n_rows, n_quantiles);
-        const auto params = predict_params{X, trained_centers_, predicted_quantiles_, accuracy_predicted_quantiles_};
-        if (threads > 1) {
-            densitas::core::task_manager manager(threads);
-            for (std::size_t i=0; i<n_rows; ++i) {
-                manager.wait_for_slot();
-                on_predict_status(prediction, models_, i, params);
-                manager.launch_new(density_estimator::predict_event, std::ref(prediction), std::ref(models_), i, std::ref(params));
+        if (densitas::matrix_adapter::n_rows(row) != 1)
+            throw densitas::densitas_error("row must be a matrix of a single row");
+        density_estimator::ensure_size(out, densitas::vector_adapter::n_elements(predicted_quantiles_));
+        const auto params = predict_params{row, trained_centers_, predicted_quantiles_, accuracy_predicted_quantiles_, exact_predicted_quantiles_, nullptr, false};
+        density_estimator::predict_row(models_, row, out, workspace, params, metrics_.get());
+    }
+
+    /**
+     * Predicts events asynchronously on the asynchronous thread pool, see
+     *  predict(). X is copied. This density estimator must outlive the
+     *  returned future and must not be trained until it is ready
+     * @param X A matrix of shape (n_events, n_features)
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A future of a matrix of shape (n_events, n_predicted_quantiles)
+     */
+    std::future<matrix_type> predict_async(const matrix_type& X, int threads=1) const
+    {
+        return predict_async(densitas::core::async_thread_pool(), X, threads);
+    }
+
+    /**
+     * Predicts events asynchronously on the given executor, see
+     *  predict_async(X, threads)
+     * @param executor The thread pool to run on. Must not be the default thread pool
+     * @param X A matrix of shape (n_events, n_features)
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     * @return A future of a matrix of shape (n_events, n_predicted_quantiles)
+     */
+    std::future<matrix_type> predict_async(densitas::core::thread_pool& executor, const matrix_type& X, int threads=1) const
+    {
+        return densitas::core::launch_async(executor, [this, X, threads]() {
+            return this->predict(X, threads);
+        });
+    }
+
+    /**
+     * Predicts events block by block as pulled from a source and pushes the
+     *  predictions of each block to a sink so that arbitrarily many events
+     *  can be predicted in bounded memory. Every thread holds at most one
+     *  block, so no more than max(threads, 1) blocks and their predictions
+     *  are in memory at any time. Calls to source and sink are serialized,
+     *  the sink receives the blocks in the order the source produced them.
+     *  on_predict_status is given row indices relative to the block, its
+     *  calls are serialized across blocks
+     * @param source Called as bool(matrix_type& block). Sets block to the
+     *  next matrix of shape (n_events, n_features) and returns true, or
+     *  returns false if there are no more events
+     * @param sink Called as void(std::size_t block_index, const matrix_type& prediction)
+     *  with prediction of shape (n_events, n_predicted_quantiles)
+     * @param threads Max number of threads to use, single-threaded if <= 1
+     */
+    template<typename Source, typename Sink>
+    void predict_stream(Source&& source, Sink&& sink, int threads=1) const
+    {
+        check_n_models(models_.size());
+        const auto n_workers = static_cast<std::size_t>(threads > 1 ? threads : 1);
+        std::mutex source_mutex;
+        std::mutex sink_mutex;
+        std::condition_variable sink_cond_var;
+        std::size_t next_block = 0;
+        std::size_t next_sink = 0;
+        bool source_done = false;
+        bool failed = false;
+        densitas::core::parallel_for(n_workers, threads, [&](std::size_t, std::size_t begin, std::size_t end) {
+            try {
+                for (std::size_t worker=begin; worker<end; ++worker) {
+                    for (;;) {
+                        auto block = densitas::matrix_adapter::construct_uninitialized<matrix_type>(0, 0);
+                        std::size_t block_index = 0;
+                        {
+                            std::lock_guard<std::mutex> lock{source_mutex};
+                            if (source_done || failed || !source(block)) {
+                                source_done = true;
+                                break;
+                            }
+                            block_index = next_block++;
+                        }
+                        const auto prediction = this->predict(block);
+                        std::unique_lock<std::mutex> lock{sink_mutex};
+                        {
+                            const densitas::core::trace_scope wait_trace{this->tracer_.get(), "wait_for_sink", "dispatch", {{"block", block_index}}};
+                            sink_cond_var.wait(lock, [&]() { return failed || next_sink == block_index; });
+                        }
+                        if (failed)
+                            return;
+                        sink(block_index, static_cast<const matrix_type&>(prediction));
+                        ++next_sink;
+                        sink_cond_var.notify_all();
+                    }
+                }
+            } catch (...) {
+                {
+                    std::lock_guard<std::mutex> source_lock{source_mutex};
+                    std::lock_guard<std::mutex> sink_lock{sink_mutex};
+                    failed = true;
+                }
+                sink_cond_var.notify_all();
+                throw;
             }
-        } else {
-            for (std::size_t i=0; i<n_rows; ++i) {
-                on_predict_status(prediction, models_, i, params);
-                density_estimator::predict_event(prediction, models_, i, params);
+        });
+    }
+
+    /**
+     * Saves this trained density estimator to a file in a versioned binary
+     *  format. Requires model_adapter::save for the model type
+     * @param filename The name of the file to write
+     */
+    void save(const std::string& filename) const
+    {
+        std::ofstream stream(filename, std::ios::binary);
+        if (!stream)
+            throw densitas::densitas_error("cannot open file for writing: " + filename);
+        save(stream);
+    }
+
+    /**
+     * Saves this trained density estimator to the given stream which must
+     *  be opened in binary mode, see save(filename)
+     * @param stream The stream to write to
+     */
+    void save(std::ostream& stream) const
+    {
+        check_n_models(models_.size());
+        if (densitas::vector_adapter::n_elements(trained_centers_) != models_.size())
+            throw densitas::densitas_error("density estimator is not trained");
+        densitas::core::binary_writer writer(stream);
+        densitas::core::write_header(writer, sizeof(element_type));
+        writer.write_value(static_cast<std::uint64_t>(models_.size()));
+        writer.write_value(static_cast<std::uint64_t>(densitas::vector_adapter::n_elements(predicted_quantiles_)));
+        writer.write_value(static_cast<std::uint64_t>(predict_batch_size_));
+        writer.write_value(static_cast<std::uint8_t>(exact_predicted_quantiles_));
+        writer.align(sizeof(element_type));
+        writer.write_value(accuracy_predicted_quantiles_);
+        density_estimator::write_elements(writer, trained_centers_);
+        density_estimator::write_elements(writer, predicted_quantiles_);
+        writer.align(8);
+        writer.write_value(static_cast<std::uint64_t>(bin_counts_.size()));
+        for (const auto count : bin_counts_) {
+            writer.write_value(static_cast<std::uint64_t>(count));
+        }
+        writer.align(64);
+        writer.write(bin_sums_.data(), bin_sums_.size() * sizeof(element_type));
+        density_estimator::write_elements(writer, trained_quantiles_);
+        for (const auto& model : models_) {
+            std::ostringstream model_stream(std::ios::binary);
+            densitas::model_adapter::save(*model, model_stream);
+            const auto model_data = model_stream.str();
+            writer.align(8);
+            writer.write_value(static_cast<std::uint64_t>(model_data.size()));
+            writer.write(model_data.data(), model_data.size());
+        }
+    }
+
+    /**
+     * Loads a density estimator saved by save(), replacing the models and
+     *  settings of this one. The file is memory-mapped and stays mapped as
+     *  long as this density estimator or one of its clones is alive so that
+     *  vector_adapter::construct_from_memory and model_adapter::load can
+     *  use the numeric data in place instead of copying it
+     * @param filename The name of the file to read
+     */
+    void load(const std::string& filename)
+    {
+        auto mapping = std::make_shared<const densitas::core::mapped_file>(filename);
+        densitas::core::binary_reader reader(mapping->data(), mapping->size());
+        const auto version = densitas::core::read_header(reader, sizeof(element_type));
+        const auto n_models = static_cast<std::size_t>(reader.read_value<std::uint64_t>());
+        check_n_models(n_models);
+        const auto n_quantiles = static_cast<std::size_t>(reader.read_value<std::uint64_t>());
+        check_n_predicted_quantiles(n_quantiles);
+        const auto batch_size = static_cast<std::size_t>(reader.read_value<std::uint64_t>());
+        if (!(batch_size > 0))
+            throw densitas::densitas_error("batch size must be larger than zero");
+        const bool exact = reader.read_value<std::uint8_t>() != 0;
+        reader.align(sizeof(element_type));
+        const auto accuracy = reader.read_value<element_type>();
+        auto centers = density_estimator::read_elements(reader, n_models);
+        auto quantiles = density_estimator::read_elements(reader, n_quantiles);
+        // version 1 has no state for partial training
+        std::vector<std::size_t> bin_counts;
+        std::vector<element_type> bin_sums;
+        auto trained_quantiles = densitas::vector_adapter::construct_uninitialized<vector_type>(0);
+        if (version > 1) {
+            reader.align(8);
+            const auto n_bins = static_cast<std::size_t>(reader.read_value<std::uint64_t>());
+            if (n_bins && n_bins != n_models)
+                throw densitas::densitas_error("number of bins not matching: " + std::to_string(n_bins));
+            for (std::size_t i=0; i<n_bins; ++i) {
+                bin_counts.push_back(static_cast<std::size_t>(reader.read_value<std::uint64_t>()));
             }
+            reader.align(64);
+            const auto sums = reinterpret_cast<const element_type*>(reader.read(n_bins * sizeof(element_type)));
+            bin_sums.assign(sums, sums + n_bins);
+            trained_quantiles = density_estimator::read_elements(reader, n_bins ? n_bins + 1 : 0);
         }
-        return prediction;
+        std::vector<std::unique_ptr<model_type>> models;
+        for (std::size_t i=0; i<n_models; ++i) {
+            reader.align(8);
+            const auto size = static_cast<std::size_t>(reader.read_value<std::uint64_t>());
+            const auto data = reader.read(size);
+            models.emplace_back(densitas::model_adapter::load<model_type>(data, size));
+            if (!models.back())
+                throw densitas::densitas_error("failed loading model: " + std::to_string(i));
+        }
+        // the previous mapping may be in use by the members replaced below
+        const auto previous_mapping = std::move(mapping_);
+        mapping_ = std::move(mapping);
+        models_ = std::move(models);
+        trained_centers_ = std::move(centers);
+        trained_quantiles_ = std::move(trained_quantiles);
+        bin_sums_ = std::move(bin_sums);
+        bin_counts_ = std::move(bin_counts);
+        predicted_quantiles_ = std::move(quantiles);
+        accuracy_predicted_quantiles_ = accuracy;
+        exact_predicted_quantiles_ = exact;
+        predict_batch_size_ = batch_size;
     }
 
     density_estimator(const density_estimator&) = delete;
@@ -160,7 +630,7 @@ protected:
      * Constructor
      */
     density_estimator()
-    : models_{}, trained_centers_{}, predicted_quantiles_{}, accuracy_predicted_quantiles_{}
+    : mapping_{}, models_{}, trained_centers_{}, trained_quantiles_{}, bin_sums_{}, bin_counts_{}, predicted_quantiles_{}, accuracy_predicted_quantiles_{}, exact_predicted_quantiles_{}, predict_batch_size_{}, predict_status_{}, metrics_{}, tracer_{}, status_mutex_{}
     {
         init();
     }
@@ -171,43 +641,75 @@ protected:
      * @param n_models The number of models to use
      */
     density_estimator(const model_type& model, std::size_t n_models)
-    : models_{}, trained_centers_{}, predicted_quantiles_{}, accuracy_predicted_quantiles_{}
+    : mapping_{}, models_{}, trained_centers_{}, trained_quantiles_{}, bin_sums_{}, bin_counts_{}, predicted_quantiles_{}, accuracy_predicted_quantiles_{}, exact_predicted_quantiles_{}, predict_batch_size_{}, predict_status_{}, metrics_{}, tracer_{}, status_mutex_{}
     {
         init();
         set_models(model, n_models);
     }
 
+    // declared first so that it outlives any members using it
+    std::shared_ptr<const densitas::core::mapped_file> mapping_;
     std::vector<std::unique_ptr<model_type>> models_;
     vector_type trained_centers_;
+    vector_type trained_quantiles_;
+    std::vector<element_type> bin_sums_;
+    std::vector<std::size_t> bin_counts_;
     vector_type predicted_quantiles_;
     element_type accuracy_predicted_quantiles_;
+    bool exact_predicted_quantiles_;
+    std::size_t predict_batch_size_;
+    // set by subclasses overriding on_predict_status
+    bool predict_status_;
+    std::shared_ptr<densitas::metrics> metrics_;
+    std::shared_ptr<densitas::tracer> tracer_;
+    mutable std::mutex status_mutex_;
 
     struct train_params {
         const vector_type& y;
         const vector_type& trained_quantiles;
+        const std::vector<densitas::math::bin_range>& bins;
+        const bool partial;
+        densitas::metrics* const metrics;
+        densitas::tracer* const tracer;
+        const densitas::cancellation_token* const token;
+        std::vector<char>* const trained;
     };
 
     struct predict_params {
         const matrix_type& features;
         const vector_type& centers;
         const vector_type& quantiles;
-        const double accuracy;
+        const element_type accuracy;
+        const bool exact;
+        // the cumulative distribution or density is predicted if given
+        const vector_type* const grid;
+        const bool density;
     };
 
     virtual void on_train_status(const model_type&, std::size_t, const matrix_type&, const train_params&) const {}
 
+    /**
+     * Called for every event before it is predicted if predict_status_ is
+     *  true. Subclasses overriding this must set predict_status_ to true,
+     *  otherwise the calls are skipped to avoid serializing the workers.
+     *  With a cancellation token, events may be reported but not predicted
+     */
     virtual void on_predict_status(const matrix_type&, const std::vector<std::unique_ptr<model_type>>&, std::size_t, const predict_params&) const {}
 
     virtual void init()
     {
         static_assert(std::is_base_of<density_estimator_type, SubType>::value, "SubType is not inheriting from density_estimator");
         densitas::core::check_element_type<element_type>();
-        accuracy_predicted_quantiles_ = 1e-2;
+        accuracy_predicted_quantiles_ = static_cast<element_type>(1e-2);
+        exact_predicted_quantiles_ = true;
+        predict_batch_size_ = 1;
+        predict_status_ = false;
         trained_centers_ = densitas::vector_adapter::construct_uninitialized<vector_type>(0);
+        trained_quantiles_ = densitas::vector_adapter::construct_uninitialized<vector_type>(0);
         predicted_quantiles_ = densitas::vector_adapter::construct_uninitialized<vector_type>(3);
-        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 0, 0.05);
-        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 1, 0.5);
-        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 2, 0.95);
+        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 0, static_cast<element_type>(0.05));
+        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 1, static_cast<element_type>(0.5));
+        densitas::vector_adapter::set_element<element_type>(predicted_quantiles_, 2, static_cast<element_type>(0.95));
     }
 
     virtual void check_n_models(std::size_t n_models) const
@@ -216,23 +718,337 @@ protected:
             throw densitas::densitas_error("number of models must be larger than one");
     }
 
-    static void train_model(model_type& model, std::size_t model_index, matrix_type features, const train_params& params)
+    virtual void check_n_predicted_quantiles(std::size_t) const {}
+
+    bool train_until(const matrix_type& X, const vector_type& y, const densitas::cancellation_token* token, int threads)
+    {
+        const densitas::core::trace_scope trace{tracer_.get(), "train", "train", {{"n_models", models_.size()}, {"threads", static_cast<std::size_t>(threads > 1 ? threads : 1)}}};
+        check_n_models(models_.size());
+        const auto metrics = metrics_.get();
+        const densitas::core::stopwatch bin_edges_watch{metrics != nullptr};
+        const auto quantiles = densitas::math::linspace<vector_type, element_type>(0, 1, models_.size() + 1);
+        auto trained_quantiles = densitas::math::quantiles<element_type>(y, quantiles);
+        density_estimator::record(metrics, densitas::metrics::phase::bin_edges, bin_edges_watch);
+        const densitas::core::stopwatch centers_watch{metrics != nullptr};
+        const auto bins = densitas::math::bin_ranges<element_type>(y, trained_quantiles);
+        std::vector<element_type> bin_sums(models_.size(), element_type{0});
+        std::vector<std::size_t> bin_counts(models_.size(), 0);
+        densitas::math::accumulate_bins<element_type>(y, bins, bin_sums, bin_counts, threads);
+        auto centers = densitas::math::make_centers<element_type, vector_type>(bin_sums, bin_counts);
+        density_estimator::record(metrics, densitas::metrics::phase::centers, centers_watch);
+        if (token) {
+            std::vector<std::unique_ptr<model_type>> models;
+            for (const auto& model : models_) {
+                models.emplace_back(densitas::model_adapter::clone(*model));
+            }
+            std::vector<char> trained(models.size(), 0);
+            const auto params = train_params{y, trained_quantiles, bins, false, metrics, tracer_.get(), token, &trained};
+            train_models(models, X, params, threads);
+            if (std::find(trained.begin(), trained.end(), 0) != trained.end())
+                return false;
+            models_ = std::move(models);
+        } else {
+            const auto params = train_params{y, trained_quantiles, bins, false, metrics, tracer_.get(), nullptr, nullptr};
+            train_models(models_, X, params, threads);
+        }
+        trained_centers_ = std::move(centers);
+        trained_quantiles_ = std::move(trained_quantiles);
+        bin_sums_ = std::move(bin_sums);
+        bin_counts_ = std::move(bin_counts);
+        return true;
+    }
+
+    void train_models(std::vector<std::unique_ptr<model_type>>& models, const matrix_type& X, const train_params& params, int threads)
+    {
+        if (threads > 1) {
+            // the first exception of a model is rethrown once all tasks have finished
+            std::exception_ptr error;
+            std::mutex error_mutex;
+            {
+                densitas::core::task_manager manager(threads);
+                for (std::size_t i=0; i<models.size(); ++i) {
+                    {
+                        const densitas::core::trace_scope trace{params.tracer, "wait_for_slot", "dispatch", {{"model", i}}};
+                        manager.wait_for_slot();
+                    }
+                    if (params.token && params.token->is_cancelled())
+                        break;
+                    {
+                        std::lock_guard<std::mutex> lock{error_mutex};
+                        if (error)
+                            break;
+                    }
+                    on_train_status(*models[i], i, X, params);
+                    manager.launch_new(density_estimator::train_model_or_capture, std::ref(*models[i]), i, std::cref(X), std::ref(params), std::ref(error), std::ref(error_mutex));
+                }
+            }
+            if (error)
+                std::rethrow_exception(error);
+        } else {
+            for (std::size_t i=0; i<models.size(); ++i) {
+                if (params.token && params.token->is_cancelled())
+                    break;
+                on_train_status(*models[i], i, X, params);
+                density_estimator::train_model(*models[i], i, X, params);
+            }
+        }
+    }
+
+    void check_bin_edges() const
+    {
+        if (densitas::vector_adapter::n_elements(trained_quantiles_) != models_.size() + 1)
+            throw densitas::densitas_error("density estimator is not trained");
+    }
+
+    matrix_type predict_until(const matrix_type& X, const vector_type* grid, bool density, const densitas::cancellation_token* token, std::vector<char>* predicted, int threads) const
+    {
+        check_n_models(models_.size());
+        const auto n_rows = densitas::matrix_adapter::n_rows(X);
+        const densitas::core::trace_scope trace{tracer_.get(), "predict", "predict", {{"n_events", n_rows}, {"threads", static_cast<std::size_t>(threads > 1 ? threads : 1)}}};
+        const auto params = predict_params{X, trained_centers_, predicted_quantiles_, accuracy_predicted_quantiles_, exact_predicted_quantiles_, grid, density};
+        auto prediction = densitas::matrix_adapter::construct_uninitialized<matrix_type>(n_rows, density_estimator::n_outputs(params));
+        const auto batch_size = predict_batch_size_;
+        // one per worker so that scratch memory does not scale with the events
+        std::vector<predict_workspace> workspaces;
+        for (int i=0; i<(threads > 1 ? threads : 1); ++i) {
+            workspaces.push_back(make_predict_workspace());
+        }
+        // the next event to call on_predict_status for, guarded by status_mutex_
+        std::size_t next_status = 0;
+        densitas::core::parallel_for(n_rows, threads, [this, &prediction, &params, &workspaces, &next_status, batch_size, token, predicted](std::size_t worker, std::size_t begin, std::size_t end) {
+            const densitas::core::trace_scope range_trace{this->tracer_.get(), "predict_range", "predict", {{"worker", worker}, {"begin", begin}, {"end", end}}};
+            // recorded locally to avoid contention, then merged once per range
+            std::unique_ptr<densitas::metrics> metrics{this->metrics_ ? new densitas::metrics : nullptr};
+            const auto step = batch_size > 1 ? batch_size : 1;
+            for (std::size_t i=begin; i<end; i+=step) {
+                if (token && token->is_cancelled())
+                    break;
+                const auto n_events = std::min(step, end - i);
+                if (this->predict_status_)
+                    this->call_predict_status(prediction, params, next_status, i + n_events);
+                if (batch_size > 1)
+                    density_estimator::predict_events(prediction, this->models_, i, n_events, params, metrics.get(), workspaces[worker]);
+                else
+                    density_estimator::predict_event(prediction, this->models_, i, params, metrics.get(), workspaces[worker]);
+                // every worker flags its own events only
+                if (predicted)
+                    std::fill(predicted->begin() + i, predicted->begin() + i + n_events, 1);
+            }
+            if (metrics)
+                this->metrics_->merge(*metrics);
+        }, batch_size);
+        return prediction;
+    }
+
+    /**
+     * Calls on_predict_status for the events from next_status up to end,
+     *  which may include events of ranges other workers have not started
+     *  yet, so that the calls are in ascending order and precede predicting
+     */
+    void call_predict_status(const matrix_type& prediction, const predict_params& params, std::size_t& next_status, std::size_t end) const
+    {
+        std::lock_guard<std::mutex> lock{status_mutex_};
+        while (next_status < end) {
+            const auto event_index = next_status++;
+            on_predict_status(prediction, models_, event_index, params);
+        }
+    }
+
+    static void record(densitas::metrics* metrics, densitas::metrics::phase phase, const densitas::core::stopwatch& watch)
     {
-        const auto lower = densitas::vector_adapter::get_element<element_type>(params.trained_quantiles, model_index);
-        const auto upper = densitas::vector_adapter::get_element<element_type>(params.trained_quantiles, model_index + 1);
-        auto target = densitas::math::make_classification_target<model_type>(params.y, lower, upper);
-        densitas::model_adapter::train(model, features, target);
+        if (metrics)
+            metrics->record(phase, watch.seconds());
     }
 
-    static void predict_event(matrix_type& prediction, const std::vector<std::unique_ptr<model_type>>& models, std::size_t event_index, const predict_params& params)
+    static void record(densitas::metrics* metrics, densitas::metrics::phase phase, std::size_t model_index, const densitas::core::stopwatch& watch)
     {
-        auto weights = densitas::vector_adapter::construct_uninitialized<vector_type>(models.size());
+        if (metrics)
+            metrics->record(phase, model_index, watch.seconds());
+    }
+
+    static void train_model(model_type& model, std::size_t model_index, const matrix_type& features, const train_params& params)
+    {
+        if (params.token && params.token->is_cancelled())
+            return;
+        const densitas::core::trace_scope trace{params.tracer, "train_model", "train", {{"model", model_index}}};
+        const densitas::core::stopwatch target_watch{params.metrics != nullptr};
+        auto target = densitas::math::make_classification_target_from_bins<model_type, element_type, vector_type>(params.bins, model_index);
+        density_estimator::record(params.metrics, densitas::metrics::phase::classification_targets, model_index, target_watch);
+        const densitas::core::stopwatch training_watch{params.metrics != nullptr};
+        if (params.partial)
+            density_estimator::partial_fit_model(model, features, target, densitas::model_adapter::partial_mutates_features<model_type, matrix_type, vector_type>{});
+        else
+            density_estimator::fit_model(model, features, target, densitas::model_adapter::mutates_features<model_type, matrix_type, vector_type>{});
+        density_estimator::record(params.metrics, densitas::metrics::phase::model_training, model_index, training_watch);
+        if (params.trained)
+            (*params.trained)[model_index] = 1;
+    }
+
+    static void train_model_or_capture(model_type& model, std::size_t model_index, const matrix_type& features, const train_params& params, std::exception_ptr& error, std::mutex& error_mutex)
+    {
+        try {
+            density_estimator::train_model(model, model_index, features, params);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock{error_mutex};
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    static void fit_model(model_type& model, const matrix_type& features, vector_type& target, std::false_type)
+    {
+        densitas::model_adapter::train<model_type, const matrix_type, vector_type>(model, features, target);
+    }
+
+    static void fit_model(model_type& model, const matrix_type& features, vector_type& target, std::true_type)
+    {
+        auto features_copy = features;
+        densitas::model_adapter::train<model_type, matrix_type, vector_type>(model, features_copy, target);
+    }
+
+    static void partial_fit_model(model_type& model, const matrix_type& features, vector_type& target, std::false_type)
+    {
+        densitas::model_adapter::partial_train<model_type, const matrix_type, vector_type>(model, features, target);
+    }
+
+    static void partial_fit_model(model_type& model, const matrix_type& features, vector_type& target, std::true_type)
+    {
+        auto features_copy = features;
+        densitas::model_adapter::partial_train<model_type, matrix_type, vector_type>(model, features_copy, target);
+    }
+
+    static void write_elements(densitas::core::binary_writer& writer, const vector_type& vector)
+    {
+        const auto n_elem = densitas::vector_adapter::n_elements(vector);
+        writer.align(64);
+        const auto data = densitas::vector_adapter::data<element_type>(vector);
+        if (data) {
+            writer.write(data, n_elem * sizeof(element_type));
+            return;
+        }
+        densitas::core::for_each_element<element_type>(vector, 0, n_elem, [&writer](std::size_t, element_type value) {
+            writer.write_value(value);
+        });
+    }
+
+    static vector_type read_elements(densitas::core::binary_reader& reader, std::size_t n_elem)
+    {
+        reader.align(64);
+        if (n_elem > std::numeric_limits<std::size_t>::max() / sizeof(element_type))
+            throw densitas::densitas_error("number of elements too large: " + std::to_string(n_elem));
+        const auto data = reader.read(n_elem * sizeof(element_type));
+        return densitas::vector_adapter::construct_from_memory<vector_type>(reinterpret_cast<const element_type*>(data), n_elem);
+    }
+
+    static void ensure_size(vector_type& vector, std::size_t n_elem)
+    {
+        if (densitas::vector_adapter::n_elements(vector) != n_elem)
+            vector = densitas::vector_adapter::construct_uninitialized<vector_type>(n_elem);
+    }
+
+    static void ensure_shape(matrix_type& matrix, std::size_t n_rows, std::size_t n_cols)
+    {
+        if (densitas::matrix_adapter::n_rows(matrix) != n_rows || densitas::matrix_adapter::n_columns(matrix) != n_cols)
+            matrix = densitas::matrix_adapter::construct_uninitialized<matrix_type>(n_rows, n_cols);
+    }
+
+    static void check_intervals(const vector_type& points, const std::string& name)
+    {
+        const auto n_points = densitas::vector_adapter::n_elements(points);
+        if (!(n_points > 1))
+            throw densitas::densitas_error(name + " must contain at least two points");
+        for (std::size_t i=1; i<n_points; ++i) {
+            if (!(densitas::vector_adapter::get_element<element_type>(points, i - 1) < densitas::vector_adapter::get_element<element_type>(points, i)))
+                throw densitas::densitas_error(name + " must be strictly increasing");
+        }
+    }
+
+    static std::size_t n_outputs(const predict_params& params)
+    {
+        if (!params.grid)
+            return densitas::vector_adapter::n_elements(params.quantiles);
+        const auto n_points = densitas::vector_adapter::n_elements(*params.grid);
+        return params.density ? n_points - 1 : n_points;
+    }
+
+    static void predict_quantiles(const vector_type& weights, vector_type& quantiles, predict_workspace& workspace, const predict_params& params)
+    {
+        if (params.grid) {
+            density_estimator::predict_distribution(weights, quantiles, workspace, params);
+            return;
+        }
+        if (params.exact)
+            densitas::math::quantiles_weighted_exact_into<element_type>(params.centers, weights, params.quantiles, workspace.scratch, quantiles);
+        else
+            densitas::math::quantiles_weighted_into<element_type>(params.centers, weights, params.quantiles, params.accuracy, workspace.scratch, quantiles);
+    }
+
+    static void predict_distribution(const vector_type& weights, vector_type& output, predict_workspace& workspace, const predict_params& params)
+    {
+        const auto& grid = *params.grid;
+        if (!params.density) {
+            densitas::math::cdf_weighted_exact_into<element_type>(params.centers, weights, grid, workspace.scratch, output);
+            return;
+        }
+        density_estimator::ensure_size(workspace.cdf, densitas::vector_adapter::n_elements(grid));
+        densitas::math::cdf_weighted_exact_into<element_type>(params.centers, weights, grid, workspace.scratch, workspace.cdf);
+        for (std::size_t i=0; i<densitas::vector_adapter::n_elements(output); ++i) {
+            const auto width = densitas::vector_adapter::get_element<element_type>(grid, i + 1) - densitas::vector_adapter::get_element<element_type>(grid, i);
+            const auto mass = densitas::vector_adapter::get_element<element_type>(workspace.cdf, i + 1) - densitas::vector_adapter::get_element<element_type>(workspace.cdf, i);
+            densitas::vector_adapter::set_element<element_type>(output, i, mass / width);
+        }
+    }
+
+    static void predict_row(const std::vector<std::unique_ptr<model_type>>& models, matrix_type& row, vector_type& quantiles, predict_workspace& workspace, const predict_params& params, densitas::metrics* metrics)
+    {
+        density_estimator::ensure_size(workspace.weights, models.size());
         for (std::size_t j=0; j<models.size(); ++j) {
-            const auto prob_value = densitas::core::predict_proba_for_row<element_type, vector_type>(*models[j], params.features, event_index);
-            densitas::vector_adapter::set_element<element_type>(weights, j, prob_value);
+            const densitas::core::stopwatch scoring_watch{metrics != nullptr};
+            densitas::model_adapter::predict_proba_into<vector_type>(*models[j], row, workspace.probas);
+            density_estimator::record(metrics, densitas::metrics::phase::model_scoring, j, scoring_watch);
+            const auto prob_value = densitas::vector_adapter::get_element<element_type>(workspace.probas, 0);
+            densitas::vector_adapter::set_element<element_type>(workspace.weights, j, prob_value);
+        }
+        const densitas::core::stopwatch quantiles_watch{metrics != nullptr};
+        density_estimator::predict_quantiles(workspace.weights, quantiles, workspace, params);
+        density_estimator::record(metrics, densitas::metrics::phase::quantile_extraction, quantiles_watch);
+    }
+
+    static void predict_event(matrix_type& prediction, const std::vector<std::unique_ptr<model_type>>& models, std::size_t event_index, const predict_params& params, densitas::metrics* metrics, predict_workspace& workspace)
+    {
+        densitas::matrix_adapter::get_row_into<element_type>(params.features, event_index, workspace.features);
+        density_estimator::ensure_size(workspace.quantiles, density_estimator::n_outputs(params));
+        density_estimator::predict_row(models, workspace.features, workspace.quantiles, workspace, params, metrics);
+        densitas::core::assign_vector_to_row<element_type>(prediction, event_index, workspace.quantiles);
+    }
+
+    static void predict_events(matrix_type& prediction, const std::vector<std::unique_ptr<model_type>>& models, std::size_t event_index, std::size_t n_events, const predict_params& params, densitas::metrics* metrics, predict_workspace& workspace)
+    {
+        density_estimator::ensure_shape(workspace.features, n_events, densitas::matrix_adapter::n_columns(params.features));
+        densitas::core::copy_rows<element_type>(params.features, event_index, n_events, workspace.features);
+        density_estimator::ensure_shape(workspace.batch_weights, n_events, models.size());
+        for (std::size_t j=0; j<models.size(); ++j) {
+            const densitas::core::stopwatch scoring_watch{metrics != nullptr};
+            densitas::model_adapter::predict_proba_into<vector_type>(*models[j], workspace.features, workspace.probas);
+            density_estimator::record(metrics, densitas::metrics::phase::model_scoring, j, scoring_watch);
+            if (densitas::vector_adapter::n_elements(workspace.probas) != n_events)
+                throw densitas::densitas_error("number of predicted probabilities not matching number of events: " + std::to_string(n_events));
+            for (std::size_t i=0; i<n_events; ++i) {
+                const auto prob_value = densitas::vector_adapter::get_element<element_type>(workspace.probas, i);
+                densitas::matrix_adapter::set_element<element_type>(workspace.batch_weights, i, j, prob_value);
+            }
+        }
+        density_estimator::ensure_size(workspace.weights, models.size());
+        density_estimator::ensure_size(workspace.quantiles, density_estimator::n_outputs(params));
+        for (std::size_t i=0; i<n_events; ++i) {
+            for (std::size_t j=0; j<models.size(); ++j) {
+                const auto weight = densitas::matrix_adapter::get_element<element_type>(workspace.batch_weights, i, j);
+                densitas::vector_adapter::set_element<element_type>(workspace.weights, j, weight);
+            }
+            const densitas::core::stopwatch quantiles_watch{metrics != nullptr};
+            density_estimator::predict_quantiles(workspace.weights, workspace.quantiles, workspace, params);
+            density_estimator::record(metrics, densitas::metrics::phase::quantile_extraction, quantiles_watch);
+            densitas::core::assign_vector_to_row<element_type>(prediction, event_index + i, workspace.quantiles);
         }
-        const auto quants = densitas::math::quantiles_weighted<element_type>(params.centers, weights, params.quantiles, params.accuracy);
-        densitas::core::assign_vector_to_row<element_type>(prediction, event_index, quants);
     }
 
 };
@@ -0,0 +1,157 @@
+#pragma once
+#include "density_estimator.hpp"
+#include <array>
+
+
+namespace densitas {
+
+/**
+ * A density estimator whose numbers of models and predicted quantiles are
+ * fixed at compile time. Training, serialization and predict() work just
+ * like for density_estimator while predict_fixed() predicts a single event
+ * keeping the centers, the model weights and the quantiles in std::array
+ * on the stack. Setting or loading a number of predicted quantiles other
+ * than NQuantiles throws.
+ *
+ * NModels: The number of models, must be larger than one
+ * NQuantiles: The number of predicted quantiles, must be larger than zero
+ * For the other template parameters see density_estimator
+ */
+template<typename SubType, typename ModelType, typename MatrixType, typename VectorType, std::size_t NModels, std::size_t NQuantiles, typename ElementType=double>
+class fixed_density_estimator : public densitas::density_estimator<SubType, ModelType, MatrixType, VectorType, ElementType> {
+public:
+
+    static_assert(NModels > 1, "number of models must be larger than one");
+    static_assert(NQuantiles > 0, "number of predicted quantiles must be larger than zero");
+
+    typedef fixed_density_estimator fixed_density_estimator_type;
+    typedef densitas::density_estimator<SubType, ModelType, MatrixType, VectorType, ElementType> density_estimator_type;
+    typedef ModelType model_type;
+    typedef MatrixType matrix_type;
+    typedef VectorType vector_type;
+    typedef ElementType element_type;
+    typedef std::array<ElementType, NModels> model_array;
+    typedef std::array<ElementType, NQuantiles> quantile_array;
+
+    /**
+     * Set the internal models using a reference model object
+     * @param model A binary classifier. Must be clonable
+     */
+    void set_models(const model_type& model)
+    {
+        density_estimator_type::set_models(model, NModels);
+    }
+
+    /**
+     * Sets the predicted quantiles which must be values between
+     *  zero and one. Default: NQuantiles values evenly spaced from 0.05
+     *  to 0.95, e.g. {0.05, 0.5, 0.95} for three, or {0.5} for one
+     * @param quantiles The predicted quantiles
+     */
+    void predicted_quantiles(const quantile_array& quantiles)
+    {
+        auto vector = densitas::vector_adapter::construct_uninitialized<vector_type>(NQuantiles);
+        for (std::size_t i=0; i<NQuantiles; ++i) {
+            densitas::vector_adapter::set_element<element_type>(vector, i, quantiles[i]);
+        }
+        density_estimator_type::predicted_quantiles(vector);
+    }
+
+    /**
+     * Predicts a single event using this trained density estimator. The
+     *  predicted quantiles are always computed exactly from the cumulative
+     *  model weights. on_predict_status is not called
+     * @param row A matrix of shape (1, n_features) given to the models as is
+     * @return The predicted quantiles
+     */
+    quantile_array predict_fixed(matrix_type& row) const
+    {
+        this->check_n_models(this->models_.size());
+        if (densitas::matrix_adapter::n_rows(row) != 1)
+            throw densitas::densitas_error("row must be a matrix of a single row");
+        if (densitas::vector_adapter::n_elements(this->trained_centers_) != NModels)
+            throw densitas::densitas_error("density estimator is not trained");
+        const auto n_quantiles = densitas::vector_adapter::n_elements(this->predicted_quantiles_);
+        if (n_quantiles != NQuantiles)
+            throw densitas::densitas_error("number of predicted quantiles not matching: " + std::to_string(n_quantiles));
+        const auto metrics = this->metrics_.get();
+        model_array centers;
+        model_array weights;
+        for (std::size_t j=0; j<NModels; ++j) {
+            centers[j] = densitas::vector_adapter::get_element<element_type>(this->trained_centers_, j);
+            const densitas::core::stopwatch scoring_watch{metrics != nullptr};
+            const auto prob_pred = densitas::model_adapter::predict_proba<vector_type>(*this->models_[j], row);
+            density_estimator_type::record(metrics, densitas::metrics::phase::model_scoring, j, scoring_watch);
+            weights[j] = densitas::vector_adapter::get_element<element_type>(prob_pred, 0);
+        }
+        quantile_array probas;
+        for (std::size_t i=0; i<NQuantiles; ++i) {
+            probas[i] = densitas::vector_adapter::get_element<element_type>(this->predicted_quantiles_, i);
+        }
+        const densitas::core::stopwatch quantiles_watch{metrics != nullptr};
+        const auto quantiles = densitas::math::quantiles_weighted_exact_fixed<element_type>(centers, weights, probas);
+        density_estimator_type::record(metrics, densitas::metrics::phase::quantile_extraction, quantiles_watch);
+        return quantiles;
+    }
+
+    virtual ~fixed_density_estimator() {}
+
+protected:
+
+    /**
+     * Constructor
+     */
+    fixed_density_estimator()
+    : density_estimator_type{}
+    {
+        predicted_quantiles(default_quantiles());
+    }
+
+    /**
+     * Constructor
+     * @param model A binary classifier. Must be clonable
+     */
+    explicit
+    fixed_density_estimator(const model_type& model)
+    : density_estimator_type{model, NModels}
+    {
+        predicted_quantiles(default_quantiles());
+    }
+
+    /**
+     * Constructor
+     * @param model A binary classifier. Must be clonable
+     * @param quantiles The predicted quantiles
+     */
+    fixed_density_estimator(const model_type& model, const quantile_array& quantiles)
+    : density_estimator_type{model, NModels}
+    {
+        predicted_quantiles(quantiles);
+    }
+
+    virtual void check_n_models(std::size_t n_models) const
+    {
+        if (n_models != NModels)
+            throw densitas::densitas_error("number of models must be " + std::to_string(NModels) + ", not: " + std::to_string(n_models));
+    }
+
+    virtual void check_n_predicted_quantiles(std::size_t n_quantiles) const
+    {
+        if (n_quantiles != NQuantiles)
+            throw densitas::densitas_error("number of predicted quantiles must be " + std::to_string(NQuantiles) + ", not: " + std::to_string(n_quantiles));
+    }
+
+    static quantile_array default_quantiles()
+    {
+        quantile_array quantiles;
+        for (std::size_t i=0; i<NQuantiles; ++i) {
+            const auto fraction = NQuantiles > 1 ? static_cast<element_type>(i) / static_cast<element_type>(NQuantiles - 1) : static_cast<element_type>(0.5);
+            quantiles[i] = static_cast<element_type>(0.05) * (1 - fraction) + static_cast<element_type>(0.95) * fraction;
+        }
+        return quantiles;
+    }
+
+};
+
+
+} // densitas
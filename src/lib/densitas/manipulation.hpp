@@ -1,6 +1,7 @@
 #pragma once
 #include "matrix_adapter.hpp"
 #include "vector_adapter.hpp"
+#include "model_adapter.hpp"
 #include "densitas_error.hpp"
 
 
@@ -19,6 +20,14 @@ void assign_vector_to_row(MatrixType& matrix, std::size_t row_index, const Vecto
     const auto n_cols = densitas::matrix_adapter::n_columns(matrix);
     if (n_cols != n_elem)
         throw densitas::densitas_error("size of vector not matching number of columns in matrix");
+    const auto target = densitas::matrix_adapter::mutable_layout<ElementType>(matrix);
+    if (target.data) {
+        const auto first = target.data + row_index*target.row_stride;
+        densitas::core::for_each_element<ElementType>(vector, 0, n_cols, [&](std::size_t i, ElementType value) {
+            first[i*target.column_stride] = value;
+        });
+        return;
+    }
     for (std::size_t i=0; i<n_cols; ++i) {
         const auto value = densitas::vector_adapter::get_element<ElementType>(vector, i);
         densitas::matrix_adapter::set_element<ElementType>(matrix, row_index, i, value);
@@ -35,6 +44,14 @@ VectorType extract_row(const MatrixType& matrix, std::size_t row_index)
         throw densitas::densitas_error("row index larger than rows in matrix: " + std::to_string(row_index));
     const auto n_cols = densitas::matrix_adapter::n_columns(matrix);
     auto vector = densitas::vector_adapter::construct_uninitialized<VectorType>(n_cols);
+    const auto source = densitas::matrix_adapter::layout<ElementType>(matrix);
+    if (source.data) {
+        const auto first = source.data + row_index*source.row_stride;
+        densitas::core::generate_elements<ElementType>(vector, 0, n_cols, [&](std::size_t i) {
+            return first[i*source.column_stride];
+        });
+        return vector;
+    }
     for (std::size_t i=0; i<n_cols; ++i) {
         const auto value = densitas::matrix_adapter::get_element<ElementType>(matrix, row_index, i);
         densitas::vector_adapter::set_element<ElementType>(vector, i, value);
@@ -43,14 +60,67 @@ VectorType extract_row(const MatrixType& matrix, std::size_t row_index)
 }
 
 
+/**
+ * Copies n_rows rows of matrix starting at row_index into the first rows
+ * of target which must have at least n_rows rows and as many columns
+ */
+template<typename ElementType, typename MatrixType>
+void copy_rows(const MatrixType& matrix, std::size_t row_index, std::size_t n_rows, MatrixType& target)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_rows_matrix = densitas::matrix_adapter::n_rows(matrix);
+    if (row_index + n_rows > n_rows_matrix)
+        throw densitas::densitas_error("row range larger than rows in matrix: " + std::to_string(row_index + n_rows));
+    const auto n_cols = densitas::matrix_adapter::n_columns(matrix);
+    if (n_rows > densitas::matrix_adapter::n_rows(target) || n_cols != densitas::matrix_adapter::n_columns(target))
+        throw densitas::densitas_error("target matrix too small for rows");
+    const auto source = densitas::matrix_adapter::layout<ElementType>(matrix);
+    const auto layout = densitas::matrix_adapter::mutable_layout<ElementType>(target);
+    if (source.data && layout.data) {
+        const auto first = source.data + row_index*source.row_stride;
+        const bool rows_inner = source.row_stride <= source.column_stride;
+        const auto n_outer = rows_inner ? n_cols : n_rows;
+        const auto n_inner = rows_inner ? n_rows : n_cols;
+        for (std::size_t k=0; k<n_outer; ++k) {
+            for (std::size_t l=0; l<n_inner; ++l) {
+                const auto i = rows_inner ? l : k;
+                const auto j = rows_inner ? k : l;
+                layout.data[i*layout.row_stride + j*layout.column_stride] = first[i*source.row_stride + j*source.column_stride];
+            }
+        }
+        return;
+    }
+    for (std::size_t i=0; i<n_rows; ++i) {
+        for (std::size_t j=0; j<n_cols; ++j) {
+            const auto value = densitas::matrix_adapter::get_element<ElementType>(matrix, row_index + i, j);
+            densitas::matrix_adapter::set_element<ElementType>(target, i, j, value);
+        }
+    }
+}
+
+
+template<typename ElementType, typename MatrixType>
+MatrixType extract_rows(const MatrixType& matrix, std::size_t row_index, std::size_t n_rows)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_rows_matrix = densitas::matrix_adapter::n_rows(matrix);
+    if (row_index + n_rows > n_rows_matrix)
+        throw densitas::densitas_error("row range larger than rows in matrix: " + std::to_string(row_index + n_rows));
+    auto rows = densitas::matrix_adapter::construct_uninitialized<MatrixType>(n_rows, densitas::matrix_adapter::n_columns(matrix));
+    densitas::core::copy_rows<ElementType>(matrix, row_index, n_rows, rows);
+    return rows;
+}
+
+
 template<typename ElementType, typename VectorType, typename MatrixType, typename ModelType>
 ElementType predict_proba_for_row(const ModelType& model, const MatrixType& X, std::size_t row_index)
 {
-    const auto n_cols = densitas::matrix_adapter::n_columns(X);
-    const auto feature_row = densitas::core::extract_row<ElementType, VectorType>(X, row_index);
-    auto feature_matrix = densitas::matrix_adapter::construct_uninitialized<MatrixType>(1, n_cols);
-    densitas::core::assign_vector_to_row<ElementType>(feature_matrix, 0, feature_row);
-    const auto prob_pred = densitas::model_adapter::predict_proba<VectorType>(model, feature_matrix);
+    densitas::core::check_element_type<ElementType>();
+    const auto n_rows = densitas::matrix_adapter::n_rows(X);
+    if (row_index > n_rows-1)
+        throw densitas::densitas_error("row index larger than rows in matrix: " + std::to_string(row_index));
+    auto feature_row = densitas::matrix_adapter::get_row<ElementType>(X, row_index);
+    const auto prob_pred = densitas::model_adapter::predict_proba<VectorType>(model, feature_row);
     return densitas::vector_adapter::get_element<ElementType>(prob_pred, 0);
 }
 
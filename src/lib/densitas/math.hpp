@@ -4,9 +4,15 @@
 #include "matrix_adapter.hpp"
 #include "vector_adapter.hpp"
 #include "densitas_error.hpp"
+#include "task_manager.hpp"
+#include "simd.hpp"
 #include <vector>
+#include <array>
 #include <algorithm>
+#include <numeric>
+#include <limits>
 #include <string>
+#include <cstdint>
 
 
 namespace densitas {
@@ -18,12 +24,134 @@ VectorType make_classification_target(const VectorType& y, ElementType lower, El
 {
     densitas::core::check_element_type<ElementType>();
     const auto n_elem = densitas::vector_adapter::n_elements(y);
+    const auto yes = static_cast<ElementType>(densitas::model_adapter::yes<ModelType>());
+    const auto no = static_cast<ElementType>(densitas::model_adapter::no<ModelType>());
     auto target = densitas::vector_adapter::construct_uninitialized<VectorType>(n_elem);
+    const auto values = densitas::vector_adapter::data<ElementType>(y);
+    const auto target_values = densitas::vector_adapter::mutable_data<ElementType>(target);
+    if (values && target_values) {
+        densitas::simd::classification_target(values, n_elem, lower, upper, yes, no, target_values);
+        return target;
+    }
+    densitas::core::for_each_element<ElementType>(y, 0, n_elem, [&](std::size_t i, ElementType value) {
+        densitas::vector_adapter::set_element<ElementType>(target, i, value<lower || value>upper ? no : yes);
+    });
+    return target;
+}
+
+
+/**
+ * Copies the elements of the vector into a std::vector
+ */
+template<typename ElementType, typename VectorType>
+std::vector<ElementType> to_std_vector(const VectorType& vector)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data)
+        return std::vector<ElementType>(data, data + n_elem);
+    std::vector<ElementType> result(n_elem);
+    for (std::size_t i=0; i<n_elem; ++i) {
+        result[i] = densitas::vector_adapter::get_element<ElementType>(vector, i);
+    }
+    return result;
+}
+
+
+/**
+ * Scratch memory of the quantile computations. Its vectors are cleared but
+ * never shrunk, so reusing it across calls avoids allocations once they
+ * have grown to the needed capacity
+ */
+template<typename ElementType>
+struct scratch_buffers {
+    std::vector<ElementType> values;
+    std::vector<ElementType> deltas;
+    std::vector<std::size_t> lower;
+    std::vector<std::size_t> ranks;
+    std::vector<std::size_t> counts;
+    std::vector<std::size_t> order;
+};
+
+
+/**
+ * Copies the vector into values, reusing their memory
+ */
+template<typename ElementType, typename VectorType>
+void assign_to_std_vector(const VectorType& vector, std::vector<ElementType>& values)
+{
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data) {
+        values.assign(data, data + n_elem);
+        return;
+    }
+    values.resize(n_elem);
     for (std::size_t i=0; i<n_elem; ++i) {
-        const auto value = densitas::vector_adapter::get_element<ElementType>(y, i);
-        const auto cls_result = value<lower || value>upper ? densitas::model_adapter::no<ModelType>() : densitas::model_adapter::yes<ModelType>();
-        densitas::vector_adapter::set_element<ElementType>(target, i, cls_result);
+        values[i] = densitas::vector_adapter::get_element<ElementType>(vector, i);
     }
+}
+
+
+/**
+ * The bins [first, last] a value belongs to. Bins are closed intervals, so
+ * a value on the edge between two bins belongs to both
+ */
+struct bin_range {
+    std::uint16_t first;
+    std::uint16_t last;
+};
+
+
+/**
+ * Computes the bins each value of data belongs to by binary search where
+ * bin j is the interval [quantiles(j), quantiles(j + 1)]. The quantiles
+ * must be sorted and there can be at most 65536 bins. Values below or
+ * above all bins are assigned to the first or last bin, respectively
+ */
+template<typename ElementType, typename VectorType>
+std::vector<densitas::math::bin_range> bin_ranges(const VectorType& data, const VectorType& quantiles)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_quant = densitas::vector_adapter::n_elements(quantiles);
+    if (!(n_quant > 1))
+        throw densitas::densitas_error("size of quantiles must be larger than one, not: " + std::to_string(n_quant));
+    const auto n_bins = n_quant - 1;
+    if (n_bins - 1 > std::numeric_limits<std::uint16_t>::max())
+        throw densitas::densitas_error("number of bins must not be larger than 65536, not: " + std::to_string(n_bins));
+    const auto edges = densitas::math::to_std_vector<ElementType>(quantiles);
+    const auto n_data = densitas::vector_adapter::n_elements(data);
+    std::vector<densitas::math::bin_range> bins(n_data);
+    densitas::core::for_each_element<ElementType>(data, 0, n_data, [&](std::size_t i, ElementType value) {
+        const std::size_t lower = std::lower_bound(edges.begin(), edges.end(), value) - edges.begin();
+        const std::size_t upper = std::upper_bound(edges.begin(), edges.end(), value) - edges.begin();
+        auto first = lower > 0 ? lower - 1 : 0;
+        auto last = upper > 0 ? std::min(upper - 1, n_bins - 1) : 0;
+        if (first > n_bins - 1) first = n_bins - 1;
+        if (last < first) last = first;
+        bins[i].first = static_cast<std::uint16_t>(first);
+        bins[i].last = static_cast<std::uint16_t>(last);
+    });
+    return bins;
+}
+
+
+/**
+ * Makes the classification target for the given bin from the precomputed
+ * bins of every value, see bin_ranges()
+ */
+template<typename ModelType, typename ElementType, typename VectorType>
+VectorType make_classification_target_from_bins(const std::vector<densitas::math::bin_range>& bins, std::size_t bin_index)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = bins.size();
+    const auto yes = static_cast<ElementType>(densitas::model_adapter::yes<ModelType>());
+    const auto no = static_cast<ElementType>(densitas::model_adapter::no<ModelType>());
+    auto target = densitas::vector_adapter::construct_uninitialized<VectorType>(n_elem);
+    densitas::core::generate_elements<ElementType>(target, 0, n_elem, [&](std::size_t i) {
+        return bin_index<bins[i].first || bin_index>bins[i].last ? no : yes;
+    });
     return target;
 }
 
@@ -35,12 +163,14 @@ ElementType minimum(const VectorType& vector)
     const auto n_elem = densitas::vector_adapter::n_elements(vector);
     if (!(n_elem > 0))
         throw densitas::densitas_error("vector is of size zero");
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data)
+        return densitas::simd::minimum(data, n_elem);
     auto minimum = std::numeric_limits<ElementType>::max();
-    for (std::size_t i=0; i<n_elem; ++i) {
-        const auto value = densitas::vector_adapter::get_element<ElementType>(vector, i);
+    densitas::core::for_each_element<ElementType>(vector, 0, n_elem, [&minimum](std::size_t, ElementType value) {
         if (value < minimum)
             minimum = value;
-    }
+    });
     return minimum;
 }
 
@@ -53,7 +183,7 @@ ElementType quantile(std::vector<ElementType>& data, ElementType proba)
         throw densitas::densitas_error("vector contains no values");
     if (proba < 0 || proba > 1)
         throw densitas::densitas_error("proba must be between zero and one, not: " + std::to_string(proba));
-    if (proba < 1.0 / data.size())
+    if (proba < ElementType{1} / data.size())
         return *std::min_element(data.begin(), data.end());
     if (proba == 1)
         return *std::max_element(data.begin(), data.end());
@@ -63,32 +193,118 @@ ElementType quantile(std::vector<ElementType>& data, ElementType proba)
     std::nth_element(data.begin(), data.begin() + ind - 1, data.end());
     const ElementType i1 = *(data.begin() + ind - 1);
     const ElementType i2 = *std::min_element(data.begin() + ind, data.end());
-    return i1 * (1. - delta) + i2 * delta;
+    return i1 * (1 - delta) + i2 * delta;
 }
 
 
-template<typename ElementType, typename VectorType>
-VectorType quantiles(const VectorType& vector, const VectorType& probas)
+/**
+ * Partially sorts data such that data[rank] is the element that would be at
+ * position rank if data was sorted, for all ranks in [first_rank, last_rank).
+ * The ranks must be sorted, unique and within [begin, end)
+ */
+template<typename ElementType>
+void nth_elements(std::vector<ElementType>& data, std::size_t begin, std::size_t end, const std::size_t* first_rank, const std::size_t* last_rank)
 {
-    densitas::core::check_element_type<ElementType>();
-    const auto n_elem = densitas::vector_adapter::n_elements(vector);
-    std::vector<ElementType> data(n_elem);
-    for (std::size_t i=0; i<n_elem; ++i) {
-        data[i] = densitas::vector_adapter::get_element<ElementType>(vector, i);
+    while (first_rank != last_rank && end - begin > 1) {
+        const auto middle = first_rank + (last_rank - first_rank) / 2;
+        std::nth_element(data.begin() + begin, data.begin() + *middle, data.begin() + end);
+        densitas::math::nth_elements(data, begin, *middle, first_rank, middle);
+        begin = *middle + 1;
+        first_rank = middle + 1;
     }
+}
+
+
+/**
+ * Computes the quantiles of the values in scratch for all given probas at
+ * once with the same interpolation as quantile(). The needed order
+ * statistics are selected by recursively partitioning the values around
+ * the median requested rank, so every value takes part in about
+ * log2(n_probas) partitions. The values are reordered
+ */
+template<typename ElementType, typename VectorType>
+void quantiles_of_values(const VectorType& probas, densitas::math::scratch_buffers<ElementType>& scratch, VectorType& quantiles)
+{
     const auto n_probas = densitas::vector_adapter::n_elements(probas);
-    auto quantiles = densitas::vector_adapter::construct_uninitialized<VectorType>(n_probas);
+    if (!n_probas)
+        return;
+    auto& data = scratch.values;
+    const auto n_elem = data.size();
+    if (!n_elem)
+        throw densitas::densitas_error("vector contains no values");
+    auto& lower = scratch.lower;
+    auto& deltas = scratch.deltas;
+    auto& ranks = scratch.ranks;
+    lower.assign(n_probas, 0);
+    deltas.assign(n_probas, 0);
+    ranks.clear();
     for (std::size_t i=0; i<n_probas; ++i) {
         const auto proba = densitas::vector_adapter::get_element<ElementType>(probas, i);
-        const auto quantile = densitas::math::quantile(data, proba);
+        if (proba < 0 || proba > 1)
+            throw densitas::densitas_error("proba must be between zero and one, not: " + std::to_string(proba));
+        if (proba < ElementType{1} / n_elem) {
+            lower[i] = 0;
+        } else if (proba == 1) {
+            lower[i] = n_elem - 1;
+        } else {
+            const ElementType pos = n_elem * proba;
+            const std::size_t ind = static_cast<std::size_t>(pos);
+            lower[i] = ind - 1;
+            deltas[i] = pos - ind;
+            ranks.push_back(ind);
+        }
+        ranks.push_back(lower[i]);
+    }
+    std::sort(ranks.begin(), ranks.end());
+    ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+    densitas::math::nth_elements(data, 0, n_elem, ranks.data(), ranks.data() + ranks.size());
+    for (std::size_t i=0; i<n_probas; ++i) {
+        const auto delta = deltas[i];
+        const ElementType i1 = data[lower[i]];
+        const ElementType quantile = delta > 0 ? i1 * (1 - delta) + data[lower[i] + 1] * delta : i1;
         densitas::vector_adapter::set_element<ElementType>(quantiles, i, quantile);
     }
+}
+
+
+/**
+ * Computes the quantiles like quantiles() into the given quantiles which
+ * must hold as many elements as probas, drawing all temporaries from scratch
+ */
+template<typename ElementType, typename VectorType>
+void quantiles_into(const VectorType& vector, const VectorType& probas, densitas::math::scratch_buffers<ElementType>& scratch, VectorType& quantiles)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_probas = densitas::vector_adapter::n_elements(probas);
+    if (n_probas != densitas::vector_adapter::n_elements(quantiles))
+        throw densitas::densitas_error("quantiles and probas must be of equal size");
+    if (!n_probas)
+        return;
+    densitas::math::assign_to_std_vector<ElementType>(vector, scratch.values);
+    densitas::math::quantiles_of_values<ElementType>(probas, scratch, quantiles);
+}
+
+
+/**
+ * Computes the quantiles for all given probas at once, see quantiles_of_values()
+ */
+template<typename ElementType, typename VectorType>
+VectorType quantiles(const VectorType& vector, const VectorType& probas)
+{
+    densitas::math::scratch_buffers<ElementType> scratch{};
+    auto quantiles = densitas::vector_adapter::construct_uninitialized<VectorType>(densitas::vector_adapter::n_elements(probas));
+    densitas::math::quantiles_into<ElementType>(vector, probas, scratch, quantiles);
     return quantiles;
 }
 
 
+/**
+ * Computes the weighted quantiles like quantiles_weighted() into the given
+ * quantiles which must hold as many elements as probas, drawing all
+ * temporaries, including the replicated values, from scratch
+ */
 template<typename ElementType, typename VectorType>
-VectorType quantiles_weighted(const VectorType& vector, const VectorType& weights, const VectorType& probas, ElementType accuracy)
+void quantiles_weighted_into(const VectorType& vector, const VectorType& weights, const VectorType& probas, ElementType accuracy, densitas::math::scratch_buffers<ElementType>& scratch, VectorType& quantiles)
 {
     densitas::core::check_element_type<ElementType>();
     const auto n_elem = densitas::vector_adapter::n_elements(vector);
@@ -96,26 +312,335 @@ VectorType quantiles_weighted(const VectorType& vector, const VectorType& weight
         throw densitas::densitas_error("vector and weights must be of equal size");
     if (!(accuracy > 0 && accuracy < 1))
         throw densitas::densitas_error("quantile accuracy must be between zero and one, not: " + std::to_string(accuracy));
+    if (densitas::vector_adapter::n_elements(probas) != densitas::vector_adapter::n_elements(quantiles))
+        throw densitas::densitas_error("quantiles and probas must be of equal size");
     auto min_weight = densitas::math::minimum<ElementType>(weights);
     if (min_weight < accuracy) min_weight = accuracy;
-    std::vector<std::size_t> counts(n_elem);
-    for (std::size_t i=0; i<n_elem; ++i) {
-        const auto weight = densitas::vector_adapter::get_element<ElementType>(weights, i);
-        counts[i] = static_cast<std::size_t>(weight / min_weight);
+    auto& counts = scratch.counts;
+    counts.resize(n_elem);
+    const auto weight_values = densitas::vector_adapter::data<ElementType>(weights);
+    if (weight_values) {
+        densitas::simd::counts(weight_values, n_elem, min_weight, counts.data());
+    } else {
+        densitas::core::for_each_element<ElementType>(weights, 0, n_elem, [&](std::size_t i, ElementType weight) {
+            counts[i] = static_cast<std::size_t>(weight / min_weight);
+        });
     }
-    const auto n_vals = std::accumulate(counts.begin(), counts.end(), 0);
-    auto extended = n_vals > 0 ? densitas::vector_adapter::construct_uninitialized<VectorType>(n_vals) : vector;
+    const auto n_vals = std::accumulate(counts.begin(), counts.end(), std::size_t{0});
     if (n_vals > 0) {
-        std::size_t index = 0;
-        for (std::size_t i=0; i<counts.size(); ++i) {
-            const auto value = densitas::vector_adapter::get_element<ElementType>(vector, i);
-            for (std::size_t j=0; j<counts[i]; ++j) {
-                densitas::vector_adapter::set_element<ElementType>(extended, index, value);
-                ++index;
+        auto& extended = scratch.values;
+        extended.clear();
+        densitas::core::for_each_element<ElementType>(vector, 0, n_elem, [&](std::size_t i, ElementType value) {
+            extended.insert(extended.end(), counts[i], value);
+        });
+    } else {
+        densitas::math::assign_to_std_vector<ElementType>(vector, scratch.values);
+    }
+    densitas::math::quantiles_of_values<ElementType>(probas, scratch, quantiles);
+}
+
+
+template<typename ElementType, typename VectorType>
+VectorType quantiles_weighted(const VectorType& vector, const VectorType& weights, const VectorType& probas, ElementType accuracy)
+{
+    densitas::math::scratch_buffers<ElementType> scratch{};
+    auto quantiles = densitas::vector_adapter::construct_uninitialized<VectorType>(densitas::vector_adapter::n_elements(probas));
+    densitas::math::quantiles_weighted_into<ElementType>(vector, weights, probas, accuracy, scratch, quantiles);
+    return quantiles;
+}
+
+
+template<typename ElementType, typename VectorType>
+bool is_sorted(const VectorType& vector)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data)
+        return std::is_sorted(data, data + n_elem);
+    for (std::size_t i=1; i<n_elem; ++i) {
+        if (densitas::vector_adapter::get_element<ElementType>(vector, i) < densitas::vector_adapter::get_element<ElementType>(vector, i - 1))
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Sets order to the indices of vector in ascending order of their values,
+ * equal values keeping their relative order like stable_sort, or clears it
+ * if vector is sorted. Sorts in place, so no allocations are made once the
+ * capacity of order suffices
+ */
+template<typename ElementType, typename VectorType>
+void sort_order(const VectorType& vector, std::vector<std::size_t>& order)
+{
+    order.clear();
+    if (densitas::math::is_sorted<ElementType>(vector))
+        return;
+    order.resize(densitas::vector_adapter::n_elements(vector));
+    std::iota(order.begin(), order.end(), std::size_t{0});
+    // ties are broken by index as stable_sort may allocate a buffer
+    std::sort(order.begin(), order.end(), [&vector](std::size_t i, std::size_t j) {
+        const auto value_i = densitas::vector_adapter::get_element<ElementType>(vector, i);
+        const auto value_j = densitas::vector_adapter::get_element<ElementType>(vector, j);
+        return value_i < value_j || (!(value_j < value_i) && i < j);
+    });
+}
+
+
+template<typename ElementType, typename VectorType>
+ElementType positive_sum(const VectorType& vector)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data)
+        return densitas::simd::positive_sum(data, n_elem);
+    const auto n_partial = densitas::simd::scalar::n_partial_sums<ElementType>();
+    ElementType partial[n_partial] = {};
+    densitas::core::for_each_element<ElementType>(vector, 0, n_elem, [&partial, n_partial](std::size_t i, ElementType value) {
+        if (value > 0) partial[i % n_partial] += value;
+    });
+    return densitas::simd::scalar::sum_partial_sums(partial);
+}
+
+
+/**
+ * Computes the weighted quantile for given proba where total is the sum of
+ * the positive weights and order lists the indices of vector in ascending
+ * order of their values, or is nullptr if vector is sorted. Negative
+ * weights count as zero, all zero weights as equal weights. The value at
+ * position i in the given order is assigned the cumulative weight up to
+ * and including i and the quantile is linearly interpolated between
+ * adjacent values, just like quantile() does for equal weights
+ */
+template<typename ElementType, typename VectorType>
+ElementType quantile_weighted_exact(const VectorType& vector, const VectorType& weights, ElementType total, ElementType proba, const std::size_t* order)
+{
+    densitas::core::check_element_type<ElementType>();
+    if (proba < 0 || proba > 1)
+        throw densitas::densitas_error("proba must be between zero and one, not: " + std::to_string(proba));
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    const bool equal_weights = !(total > 0);
+    const ElementType target = proba * (equal_weights ? static_cast<ElementType>(n_elem) : total);
+    const auto values = densitas::vector_adapter::data<ElementType>(vector);
+    const auto weight_values = densitas::vector_adapter::data<ElementType>(weights);
+    ElementType cumulative = 0;
+    ElementType previous_cumulative = 0;
+    ElementType previous_value = 0;
+    bool has_previous = false;
+    for (std::size_t i=0; i<n_elem; ++i) {
+        const auto index = order ? order[i] : i;
+        const auto weight = equal_weights ? ElementType{1} : weight_values ? weight_values[index] : densitas::vector_adapter::get_element<ElementType>(weights, index);
+        if (!(weight > 0))
+            continue;
+        const auto value = values ? values[index] : densitas::vector_adapter::get_element<ElementType>(vector, index);
+        cumulative += weight;
+        if (target <= cumulative) {
+            if (!has_previous)
+                return value;
+            const auto delta = (target - previous_cumulative) / (cumulative - previous_cumulative);
+            return previous_value + (value - previous_value) * delta;
+        }
+        previous_cumulative = cumulative;
+        previous_value = value;
+        has_previous = true;
+    }
+    return previous_value;
+}
+
+
+/**
+ * Computes the weighted quantiles like quantiles_weighted_exact() into the
+ * given quantiles which must hold as many elements as probas. The order
+ * of the values is kept in scratch if they are not sorted, so that no
+ * allocations are made once its capacity suffices
+ */
+template<typename ElementType, typename VectorType>
+void quantiles_weighted_exact_into(const VectorType& vector, const VectorType& weights, const VectorType& probas, densitas::math::scratch_buffers<ElementType>& scratch, VectorType& quantiles)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    if (n_elem != densitas::vector_adapter::n_elements(weights))
+        throw densitas::densitas_error("vector and weights must be of equal size");
+    if (!(n_elem > 0))
+        throw densitas::densitas_error("vector contains no values");
+    const auto n_probas = densitas::vector_adapter::n_elements(probas);
+    if (n_probas != densitas::vector_adapter::n_elements(quantiles))
+        throw densitas::densitas_error("quantiles and probas must be of equal size");
+    auto& order = scratch.order;
+    densitas::math::sort_order<ElementType>(vector, order);
+    const auto total = densitas::math::positive_sum<ElementType>(weights);
+    for (std::size_t i=0; i<n_probas; ++i) {
+        const auto proba = densitas::vector_adapter::get_element<ElementType>(probas, i);
+        const auto quantile = densitas::math::quantile_weighted_exact<ElementType>(vector, weights, total, proba, order.empty() ? nullptr : order.data());
+        densitas::vector_adapter::set_element<ElementType>(quantiles, i, quantile);
+    }
+}
+
+
+/**
+ * Computes the weighted quantiles in a single cumulative pass over the
+ * values per proba. No allocations besides the result are made if the
+ * values are sorted in ascending order, which is the case for the
+ * centers of a trained density estimator
+ */
+template<typename ElementType, typename VectorType>
+VectorType quantiles_weighted_exact(const VectorType& vector, const VectorType& weights, const VectorType& probas)
+{
+    densitas::math::scratch_buffers<ElementType> scratch{};
+    auto quantiles = densitas::vector_adapter::construct_uninitialized<VectorType>(densitas::vector_adapter::n_elements(probas));
+    densitas::math::quantiles_weighted_exact_into<ElementType>(vector, weights, probas, scratch, quantiles);
+    return quantiles;
+}
+
+
+/**
+ * Evaluates the weighted cumulative distribution of the values at the
+ * points of grid into the given cdf which must hold as many elements as
+ * grid. The distribution is the inverse of the one quantiles_weighted_exact()
+ * interpolates, i.e., it is zero below the smallest value, jumps to the
+ * weight of the smallest value at it, is linear in between adjacent values
+ * and one from the largest value on. The grid must be sorted in ascending
+ * order, so a single cumulative pass over the values covers all points.
+ * The order of the values is kept in scratch if they are not sorted, so
+ * that no allocations are made once its capacity suffices
+ */
+template<typename ElementType, typename VectorType>
+void cdf_weighted_exact_into(const VectorType& vector, const VectorType& weights, const VectorType& grid, densitas::math::scratch_buffers<ElementType>& scratch, VectorType& cdf)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_elem = densitas::vector_adapter::n_elements(vector);
+    if (n_elem != densitas::vector_adapter::n_elements(weights))
+        throw densitas::densitas_error("vector and weights must be of equal size");
+    if (!(n_elem > 0))
+        throw densitas::densitas_error("vector contains no values");
+    const auto n_points = densitas::vector_adapter::n_elements(grid);
+    if (n_points != densitas::vector_adapter::n_elements(cdf))
+        throw densitas::densitas_error("cdf and grid must be of equal size");
+    if (!densitas::math::is_sorted<ElementType>(grid))
+        throw densitas::densitas_error("grid must be sorted in ascending order");
+    auto& order = scratch.order;
+    densitas::math::sort_order<ElementType>(vector, order);
+    const auto total = densitas::math::positive_sum<ElementType>(weights);
+    const bool equal_weights = !(total > 0);
+    const ElementType norm = equal_weights ? static_cast<ElementType>(n_elem) : total;
+    // the values up to position are at most the current point
+    std::size_t position = 0;
+    ElementType cumulative = 0;
+    ElementType last_value = 0;
+    bool has_last = false;
+    for (std::size_t p=0; p<n_points; ++p) {
+        const auto point = densitas::vector_adapter::get_element<ElementType>(grid, p);
+        ElementType next_value = 0;
+        ElementType next_weight = 0;
+        bool has_next = false;
+        for (; position<n_elem; ++position) {
+            const auto index = order.empty() ? position : order[position];
+            const auto weight = equal_weights ? ElementType{1} : densitas::vector_adapter::get_element<ElementType>(weights, index);
+            if (!(weight > 0))
+                continue;
+            const auto value = densitas::vector_adapter::get_element<ElementType>(vector, index);
+            if (value > point) {
+                next_value = value;
+                next_weight = weight;
+                has_next = true;
+                break;
+            }
+            cumulative += weight;
+            last_value = value;
+            has_last = true;
+        }
+        ElementType probability = 0;
+        if (has_last && !has_next)
+            probability = 1;
+        else if (has_last)
+            probability = std::min<ElementType>((cumulative + (point - last_value) / (next_value - last_value) * next_weight) / norm, 1);
+        densitas::vector_adapter::set_element<ElementType>(cdf, p, probability);
+    }
+}
+
+
+/**
+ * Evaluates the weighted cumulative distribution of the values at the
+ * points of grid, see cdf_weighted_exact_into()
+ */
+template<typename ElementType, typename VectorType>
+VectorType cdf_weighted_exact(const VectorType& vector, const VectorType& weights, const VectorType& grid)
+{
+    densitas::math::scratch_buffers<ElementType> scratch{};
+    auto cdf = densitas::vector_adapter::construct_uninitialized<VectorType>(densitas::vector_adapter::n_elements(grid));
+    densitas::math::cdf_weighted_exact_into<ElementType>(vector, weights, grid, scratch, cdf);
+    return cdf;
+}
+
+
+/**
+ * Computes the weighted quantiles like quantiles_weighted_exact() for
+ * sizes known at compile time. The values, their order and the result are
+ * kept on the stack, so no allocations are made and the loops over the
+ * values can be unrolled
+ */
+template<typename ElementType, std::size_t NValues, std::size_t NProbas>
+std::array<ElementType, NProbas> quantiles_weighted_exact_fixed(const std::array<ElementType, NValues>& values, const std::array<ElementType, NValues>& weights, const std::array<ElementType, NProbas>& probas)
+{
+    densitas::core::check_element_type<ElementType>();
+    static_assert(NValues > 0, "vector contains no values");
+    std::array<std::size_t, NValues> order;
+    for (std::size_t i=0; i<NValues; ++i) {
+        order[i] = i;
+    }
+    // insertion sort keeps equal values in place just like stable_sort
+    for (std::size_t i=1; i<NValues; ++i) {
+        const auto index = order[i];
+        std::size_t j = i;
+        for (; j>0 && values[index] < values[order[j-1]]; --j) {
+            order[j] = order[j-1];
+        }
+        order[j] = index;
+    }
+    ElementType total = 0;
+    for (std::size_t i=0; i<NValues; ++i) {
+        if (weights[i] > 0)
+            total += weights[i];
+    }
+    const bool equal_weights = !(total > 0);
+    std::array<ElementType, NProbas> quantiles;
+    for (std::size_t p=0; p<NProbas; ++p) {
+        const auto proba = probas[p];
+        if (proba < 0 || proba > 1)
+            throw densitas::densitas_error("proba must be between zero and one, not: " + std::to_string(proba));
+        const ElementType target = proba * (equal_weights ? static_cast<ElementType>(NValues) : total);
+        ElementType cumulative = 0;
+        ElementType previous_cumulative = 0;
+        ElementType previous_value = 0;
+        bool has_previous = false;
+        bool found = false;
+        for (std::size_t i=0; i<NValues && !found; ++i) {
+            const auto index = order[i];
+            const auto weight = equal_weights ? ElementType{1} : weights[index];
+            if (!(weight > 0))
+                continue;
+            const auto value = values[index];
+            cumulative += weight;
+            if (target <= cumulative) {
+                if (!has_previous) {
+                    quantiles[p] = value;
+                } else {
+                    const auto delta = (target - previous_cumulative) / (cumulative - previous_cumulative);
+                    quantiles[p] = previous_value + (value - previous_value) * delta;
+                }
+                found = true;
             }
+            previous_cumulative = cumulative;
+            previous_value = value;
+            has_previous = true;
         }
+        if (!found)
+            quantiles[p] = previous_value;
     }
-    return densitas::math::quantiles<ElementType>(extended, probas);
+    return quantiles;
 }
 
 
@@ -129,13 +654,36 @@ VectorType linspace(ElementType start, ElementType end, std::size_t n)
         throw densitas::densitas_error("n must be larger than one, not: " + std::to_string(n));
     const auto delta = (end - start) / (n - 1);
     auto linspace = densitas::vector_adapter::construct_uninitialized<VectorType>(n);
-    for (std::size_t i=0; i<n; ++i) {
-        densitas::vector_adapter::set_element<ElementType>(linspace, i, start + i*delta);
+    const auto data = densitas::vector_adapter::mutable_data<ElementType>(linspace);
+    if (data) {
+        densitas::simd::linspace(start, delta, n, data);
+        return linspace;
     }
+    densitas::core::generate_elements<ElementType>(linspace, 0, n, [start, delta](std::size_t i) {
+        return start + i*delta;
+    });
     return linspace;
 }
 
 
+template<typename ElementType, typename VectorType>
+VectorType make_centers(const std::vector<ElementType>& accumulator, const std::vector<std::size_t>& counter)
+{
+    const auto n_elem = accumulator.size();
+    auto centers = densitas::vector_adapter::construct_uninitialized<VectorType>(n_elem);
+    densitas::core::generate_elements<ElementType>(centers, 0, n_elem, [&](std::size_t j) {
+        const auto count = counter[j]==0 ? 1 : counter[j];
+        return accumulator[j] / count;
+    });
+    return centers;
+}
+
+
+/**
+ * Computes the mean of the values in each bin where bin j is the interval
+ * [quantiles(j), quantiles(j + 1)]. The quantiles must be sorted. The
+ * bins of each value are found by binary search
+ */
 template<typename ElementType, typename VectorType>
 VectorType centers(const VectorType& data, const VectorType& quantiles)
 {
@@ -147,28 +695,84 @@ VectorType centers(const VectorType& data, const VectorType& quantiles)
     if (!(n_quant > 1))
         throw densitas::densitas_error("size of quantiles must be larger than one, not: " + std::to_string(n_quant));
     const auto n_elem = n_quant - 1;
+    const auto edges = densitas::math::to_std_vector<ElementType>(quantiles);
     std::vector<std::size_t> counter(n_elem, 0);
-    std::vector<ElementType> accumulator(n_elem, 0.);
-    for (std::size_t i=0; i<n_data; ++i) {
-        int current_j = -1;
-        const auto value = densitas::vector_adapter::get_element<ElementType>(data, i);
-        for (std::size_t j=0; j<n_elem; ++j) {
-            const auto first = densitas::vector_adapter::get_element<ElementType>(quantiles, j);
-            const auto second = densitas::vector_adapter::get_element<ElementType>(quantiles, j + 1);
-            if (value>=first && value<=second) {
-                accumulator[j] += value;
-                ++counter[j];
-                current_j = j;
-            }
-            if (current_j>0 && static_cast<size_t>(current_j)!=j) break;
+    std::vector<ElementType> accumulator(n_elem, ElementType{0});
+    densitas::core::for_each_element<ElementType>(data, 0, n_data, [&](std::size_t, ElementType value) {
+        if (!(value >= edges.front() && value <= edges.back()))
+            return;
+        const std::size_t lower = std::lower_bound(edges.begin(), edges.end(), value) - edges.begin();
+        const std::size_t upper = std::upper_bound(edges.begin(), edges.end(), value) - edges.begin();
+        const auto first = lower > 0 ? lower - 1 : 0;
+        const auto last = std::min(upper - 1, n_elem - 1);
+        for (std::size_t j=first; j<=last; ++j) {
+            accumulator[j] += value;
+            ++counter[j];
+        }
+    });
+    return densitas::math::make_centers<ElementType, VectorType>(accumulator, counter);
+}
+
+
+/**
+ * Adds the values in data to the accumulator and counter of each of their
+ * bins, see bin_ranges(). The number of bins is the size of the
+ * accumulator. The data is split into one block per thread, each with its
+ * own accumulators, which are added in block order so that the result
+ * only depends on the number of threads
+ */
+template<typename ElementType, typename VectorType>
+void accumulate_bins(const VectorType& data, const std::vector<densitas::math::bin_range>& bins, std::vector<ElementType>& accumulator, std::vector<std::size_t>& counter, int threads=1)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_data = densitas::vector_adapter::n_elements(data);
+    if (bins.size() != n_data)
+        throw densitas::densitas_error("data and bins must be of equal size");
+    const auto n_bins = accumulator.size();
+    if (!(n_bins > 0))
+        throw densitas::densitas_error("number of bins must be larger than zero");
+    if (counter.size() != n_bins)
+        throw densitas::densitas_error("accumulator and counter must be of equal size");
+    if (!n_data)
+        return;
+    const auto n_blocks = std::min(static_cast<std::size_t>(threads < 1 ? 1 : threads), n_data);
+    std::vector<std::vector<std::size_t>> counters(n_blocks, std::vector<std::size_t>(n_bins, 0));
+    std::vector<std::vector<ElementType>> accumulators(n_blocks, std::vector<ElementType>(n_bins, ElementType{0}));
+    densitas::core::parallel_for(n_blocks, threads, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t k=begin; k<end; ++k) {
+            auto& block_counter = counters[k];
+            auto& block_accumulator = accumulators[k];
+            densitas::core::for_each_element<ElementType>(data, k*n_data/n_blocks, (k + 1)*n_data/n_blocks, [&](std::size_t i, ElementType value) {
+                for (std::size_t j=bins[i].first; j<=bins[i].last && j<n_bins; ++j) {
+                    block_accumulator[j] += value;
+                    ++block_counter[j];
+                }
+            });
+        }
+    });
+    for (std::size_t k=0; k<n_blocks; ++k) {
+        for (std::size_t j=0; j<n_bins; ++j) {
+            accumulator[j] += accumulators[k][j];
+            counter[j] += counters[k][j];
         }
     }
-    auto centers = densitas::vector_adapter::construct_uninitialized<VectorType>(n_elem);
-    for (std::size_t j=0; j<n_elem; ++j) {
-        if (counter[j]==0) counter[j] = 1;
-        densitas::vector_adapter::set_element<ElementType>(centers, j, accumulator[j] / counter[j]);
-    }
-    return centers;
+}
+
+
+/**
+ * Computes the mean of the values in each bin from the precomputed bins of
+ * every value, see bin_ranges() and accumulate_bins()
+ */
+template<typename ElementType, typename VectorType>
+VectorType centers_from_bins(const VectorType& data, const std::vector<densitas::math::bin_range>& bins, std::size_t n_bins, int threads=1)
+{
+    densitas::core::check_element_type<ElementType>();
+    if (!(densitas::vector_adapter::n_elements(data) > 0))
+        throw densitas::densitas_error("size of data is zero");
+    std::vector<std::size_t> counter(n_bins, 0);
+    std::vector<ElementType> accumulator(n_bins, ElementType{0});
+    densitas::math::accumulate_bins<ElementType>(data, bins, accumulator, counter, threads);
+    return densitas::math::make_centers<ElementType, VectorType>(accumulator, counter);
 }
 
 
@@ -1,10 +1,24 @@
 #pragma once
 #include "type_check.hpp"
+#include "vector_adapter.hpp"
+#include <type_traits>
 
 
 namespace densitas {
 namespace matrix_adapter {
 
+/**
+ * Where the elements of a matrix are in memory: the element at row i and
+ * column j is at data[i*row_stride + j*column_stride]. data is nullptr if
+ * the matrix does not expose its memory
+ */
+template<typename ElementType>
+struct memory_layout {
+    ElementType* data;
+    std::size_t row_stride;
+    std::size_t column_stride;
+};
+
 /**
  * Constructs a new, uninitialized matrix
  */
@@ -52,6 +66,83 @@ void set_element(MatrixType& matrix, std::size_t row_index, std::size_t col_inde
     matrix(row_index, col_index) = value;
 }
 
+/**
+ * Declares whether the matrix exposes its elements in column-major order
+ * through a memptr() method like armadillo. Only then the default layout()
+ * uses that memory, bypassing get_element and set_element. Defaults to false,
+ * specialize this deriving from std::true_type to enable it
+ */
+template<typename MatrixType>
+struct column_major_memptr : std::false_type {};
+
+/**
+ * Returns the memory layout of the matrix. If available, it is used for bulk
+ * access instead of get_element. By default, the memory is only exposed if
+ * column_major_memptr is true for the matrix. Specialize this for other
+ * layouts
+ */
+template<typename ElementType, typename MatrixType>
+densitas::matrix_adapter::memory_layout<const ElementType> layout(const MatrixType& matrix)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto data = densitas::matrix_adapter::column_major_memptr<MatrixType>::value ? densitas::core::memptr<const ElementType>(matrix, 0) : nullptr;
+    const auto n_rows = data ? densitas::matrix_adapter::n_rows(matrix) : 0;
+    return densitas::matrix_adapter::memory_layout<const ElementType>{data, 1, n_rows};
+}
+
+/**
+ * Returns the memory layout of the mutable matrix, see layout()
+ */
+template<typename ElementType, typename MatrixType>
+densitas::matrix_adapter::memory_layout<ElementType> mutable_layout(MatrixType& matrix)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto data = densitas::matrix_adapter::column_major_memptr<MatrixType>::value ? densitas::core::memptr<ElementType>(matrix, 0) : nullptr;
+    const auto n_rows = data ? densitas::matrix_adapter::n_rows(matrix) : 0;
+    return densitas::matrix_adapter::memory_layout<ElementType>{data, 1, n_rows};
+}
+
+/**
+ * Sets row to a matrix of shape (1, n_columns) holding the row at given
+ * index, reusing the memory of row if it has that shape already. Used to
+ * predict single events. Specialize this to make row share memory with the
+ * given matrix if your matrix type supports it
+ */
+template<typename ElementType, typename MatrixType>
+void get_row_into(const MatrixType& matrix, std::size_t row_index, MatrixType& row)
+{
+    densitas::core::check_element_type<ElementType>();
+    const auto n_cols = densitas::matrix_adapter::n_columns(matrix);
+    if (densitas::matrix_adapter::n_rows(row) != 1 || densitas::matrix_adapter::n_columns(row) != n_cols)
+        row = densitas::matrix_adapter::construct_uninitialized<MatrixType>(1, n_cols);
+    const auto source = densitas::matrix_adapter::layout<ElementType>(matrix);
+    const auto target = densitas::matrix_adapter::mutable_layout<ElementType>(row);
+    if (source.data && target.data) {
+        const auto first = source.data + row_index*source.row_stride;
+        for (std::size_t i=0; i<n_cols; ++i) {
+            target.data[i*target.column_stride] = first[i*source.column_stride];
+        }
+        return;
+    }
+    for (std::size_t i=0; i<n_cols; ++i) {
+        const auto value = densitas::matrix_adapter::get_element<ElementType>(matrix, row_index, i);
+        densitas::matrix_adapter::set_element<ElementType>(row, 0, i, value);
+    }
+}
+
+/**
+ * Returns a matrix of shape (1, n_columns) holding the row at given index.
+ * Specialize this to return a matrix sharing memory with the given matrix
+ * if your matrix type supports it
+ */
+template<typename ElementType, typename MatrixType>
+MatrixType get_row(const MatrixType& matrix, std::size_t row_index)
+{
+    auto row = densitas::matrix_adapter::construct_uninitialized<MatrixType>(1, densitas::matrix_adapter::n_columns(matrix));
+    densitas::matrix_adapter::get_row_into<ElementType>(matrix, row_index, row);
+    return row;
+}
+
 
 } // matrix_adapter
 } // densitas
@@ -0,0 +1,124 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstddef>
+
+
+namespace densitas {
+
+
+/**
+ * Records the wall time spent in the phases of training and predicting a
+ * density estimator, overall and per model, with a count, the total, the
+ * minimum, the maximum and a latency histogram. Timings accumulate over
+ * calls until reset() is called. All methods are thread-safe
+ */
+class metrics {
+public:
+
+    enum class phase {
+        bin_edges,              // quantiles of the target used as bin edges
+        centers,                // the bins of the target and their centers
+        classification_targets, // the classification target of each model
+        model_training,         // training of each model
+        model_scoring,          // predict_proba of each model
+        quantile_extraction     // weighted quantiles of each event
+    };
+
+    static const std::size_t n_phases = 6;
+
+    /**
+     * Bucket 0 counts durations below one microsecond and bucket k > 0
+     * those in [2^(k-1), 2^k) microseconds. The last bucket also counts
+     * all longer durations
+     */
+    static const std::size_t n_buckets = 32;
+
+    struct summary {
+        std::size_t count;
+        double total_seconds;
+        double min_seconds;
+        double max_seconds;
+        std::array<std::size_t, n_buckets> histogram;
+    };
+
+    metrics();
+
+    virtual ~metrics();
+
+    /**
+     * Records the duration of a phase
+     */
+    void record(densitas::metrics::phase phase, double seconds);
+
+    /**
+     * Records the duration of a phase for the model at given index. It is
+     * also added to the overall summary of the phase
+     */
+    void record(densitas::metrics::phase phase, std::size_t model_index, double seconds);
+
+    /**
+     * Adds the timings recorded by other to this one
+     */
+    void merge(const densitas::metrics& other);
+
+    void reset();
+
+    /**
+     * Returns the overall summary of a phase
+     */
+    densitas::metrics::summary get(densitas::metrics::phase phase) const;
+
+    /**
+     * Returns the summary of a phase for the model at given index, which is
+     * empty if nothing was recorded for the model
+     */
+    densitas::metrics::summary get(densitas::metrics::phase phase, std::size_t model_index) const;
+
+    /**
+     * Returns one more than the largest model index recorded for a phase
+     */
+    std::size_t n_models(densitas::metrics::phase phase) const;
+
+    /**
+     * Returns the histogram bucket of a duration
+     */
+    static std::size_t bucket(double seconds);
+
+    metrics(const metrics&) = delete;
+    metrics& operator=(const metrics&) = delete;
+    metrics(metrics&&) = delete;
+    metrics& operator=(metrics&&) = delete;
+
+protected:
+    mutable std::mutex mutex_;
+    std::array<densitas::metrics::summary, n_phases> phases_;
+    std::array<std::vector<densitas::metrics::summary>, n_phases> models_;
+};
+
+
+namespace core {
+
+
+/**
+ * Measures the wall time since construction. A disabled stopwatch does not
+ * read the clock and always returns zero seconds
+ */
+class stopwatch {
+public:
+
+    explicit
+    stopwatch(bool enabled=true);
+
+    double seconds() const;
+
+protected:
+    bool enabled_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+
+} // core
+} // densitas
@@ -1,8 +1,64 @@
 #pragma once
+#include "densitas_error.hpp"
 #include <memory>
+#include <ostream>
+#include <type_traits>
+#include <utility>
 
 
 namespace densitas {
+namespace core {
+
+
+template<typename ModelType, typename MatrixType, typename VectorType>
+class has_const_features_train {
+    template<typename M>
+    static auto test(int) -> decltype(std::declval<M&>().train(std::declval<const MatrixType&>(), std::declval<VectorType&>()), std::true_type());
+    template<typename>
+    static std::false_type test(...);
+public:
+    static constexpr bool value = decltype(test<ModelType>(0))::value;
+};
+
+
+template<typename ModelType, typename MatrixType, typename VectorType>
+class has_const_features_partial_train {
+    template<typename M>
+    static auto test(int) -> decltype(std::declval<M&>().partial_train(std::declval<const MatrixType&>(), std::declval<VectorType&>()), std::true_type());
+    template<typename>
+    static std::false_type test(...);
+public:
+    static constexpr bool value = decltype(test<ModelType>(0))::value;
+};
+
+
+template<typename ModelType, typename MatrixType, typename VectorType>
+class has_partial_train {
+    template<typename M>
+    static auto test(int) -> decltype(std::declval<M&>().partial_train(std::declval<MatrixType&>(), std::declval<VectorType&>()), std::true_type());
+    template<typename>
+    static std::false_type test(...);
+public:
+    static constexpr bool value = decltype(test<ModelType>(0))::value;
+};
+
+
+template<typename ModelType, typename MatrixType, typename VectorType>
+void partial_train(ModelType& model, MatrixType& X, VectorType& y, std::true_type)
+{
+    model.partial_train(X, y);
+}
+
+template<typename ModelType, typename MatrixType, typename VectorType>
+void partial_train(ModelType&, MatrixType&, VectorType&, std::false_type)
+{
+    throw densitas::densitas_error("model does not support partial training");
+}
+
+
+} // core
+
+
 namespace model_adapter {
 
 /**
@@ -19,7 +75,9 @@ std::unique_ptr<ModelType> clone(const ModelType& model)
 
 /**
  * Trains the model with given features X and target y. y should be
- * a binary target containing 'yes' and 'no'
+ * a binary target containing 'yes' and 'no'. The density estimator calls
+ * it with MatrixType being the const matrix type unless mutates_features
+ * is true, so specialize it for that MatrixType
  */
 template<typename ModelType, typename MatrixType, typename VectorType>
 void train(ModelType& model, MatrixType& X, VectorType& y)
@@ -27,6 +85,45 @@ void train(ModelType& model, MatrixType& X, VectorType& y)
     model.train(X, y);
 }
 
+/**
+ * Updates the trained model with the additional features X and target y
+ * only. Calls the model's partial_train method if it has one, otherwise
+ * throws a densitas_error. Only needed to partially train a density
+ * estimator. The density estimator calls it with MatrixType being the
+ * const matrix type unless partial_mutates_features is true. Specialize
+ * supports_partial_train along with it
+ */
+template<typename ModelType, typename MatrixType, typename VectorType>
+void partial_train(ModelType& model, MatrixType& X, VectorType& y)
+{
+    densitas::core::partial_train(model, X, y, std::integral_constant<bool, densitas::core::has_partial_train<ModelType, MatrixType, VectorType>::value>{});
+}
+
+/**
+ * Declares whether training the model modifies the features X. If so, the
+ * density estimator trains every model on its own copy of X, otherwise all
+ * models share the same read-only X. Defaults to false if the model's
+ * train method accepts a const X
+ */
+template<typename ModelType, typename MatrixType, typename VectorType>
+struct mutates_features : std::integral_constant<bool, !densitas::core::has_const_features_train<ModelType, MatrixType, VectorType>::value> {};
+
+/**
+ * Declares whether the model can be trained partially. The density
+ * estimator checks it before updating any model. Defaults to true if the
+ * model has a partial_train method. Specialize it along with partial_train()
+ */
+template<typename ModelType, typename MatrixType, typename VectorType>
+struct supports_partial_train : std::integral_constant<bool, densitas::core::has_partial_train<ModelType, MatrixType, VectorType>::value> {};
+
+/**
+ * Declares whether partially training the model modifies the features X,
+ * see mutates_features. Defaults to false if the model's partial_train
+ * method accepts a const X
+ */
+template<typename ModelType, typename MatrixType, typename VectorType>
+struct partial_mutates_features : std::integral_constant<bool, !densitas::core::has_const_features_partial_train<ModelType, MatrixType, VectorType>::value> {};
+
 /**
  * Predicts events using a trained model for given features X. Should
  * return probability values between 0 and 1
@@ -37,6 +134,39 @@ VectorType predict_proba(const ModelType& model, MatrixType& X)
     return model.predict_proba(X);
 }
 
+/**
+ * Predicts events like predict_proba() into the given probabilities. Used
+ * by the density estimator for all predictions, reusing probas per worker.
+ * Specialize it to reuse the memory of probas if your model supports it
+ */
+template<typename VectorType, typename ModelType, typename MatrixType>
+void predict_proba_into(const ModelType& model, MatrixType& X, VectorType& probas)
+{
+    probas = densitas::model_adapter::predict_proba<VectorType>(model, X);
+}
+
+/**
+ * Writes the trained model to the binary stream. Only needed to save a
+ * density estimator
+ */
+template<typename ModelType>
+void save(const ModelType& model, std::ostream& stream)
+{
+    model.save(stream);
+}
+
+/**
+ * Returns a model from the size bytes at data as written by save(). data is
+ * aligned to at least 8 bytes and stays valid as long as the loaded density
+ * estimator and its clones are alive, so the model may use it in place.
+ * Only needed to load a density estimator
+ */
+template<typename ModelType>
+std::unique_ptr<ModelType> load(const char* data, std::size_t size)
+{
+    return ModelType::load(data, size);
+}
+
 /**
  * Returns the numerical representation of 'yes' as valid for the model type
  */
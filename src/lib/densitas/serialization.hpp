@@ -0,0 +1,151 @@
+#pragma once
+#include "densitas_error.hpp"
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+
+namespace densitas {
+namespace core {
+
+/**
+ * The version of the binary format written by density_estimator::save.
+ * Bump it whenever the layout changes
+ */
+const std::uint32_t serialization_format_version = 2;
+
+
+/**
+ * Writes binary data to a stream keeping track of the offset so that
+ * data can be aligned relative to the start of the stream
+ */
+class binary_writer {
+public:
+
+    explicit
+    binary_writer(std::ostream& stream);
+
+    virtual ~binary_writer();
+
+    void write(const void* data, std::size_t size);
+
+    template<typename T>
+    void write_value(const T& value)
+    {
+        static_assert(std::is_pod<T>::value, "T is not a POD type");
+        write(&value, sizeof(T));
+    }
+
+    /**
+     * Writes zeros until the offset is a multiple of alignment
+     */
+    void align(std::size_t alignment);
+
+    std::size_t offset() const;
+
+    binary_writer(const binary_writer&) = delete;
+    binary_writer& operator=(const binary_writer&) = delete;
+    binary_writer(binary_writer&&) = delete;
+    binary_writer& operator=(binary_writer&&) = delete;
+
+protected:
+    std::ostream& stream_;
+    std::size_t offset_;
+};
+
+
+/**
+ * Reads binary data in place from a block of memory. Throws a
+ * densitas_error when reading past the end
+ */
+class binary_reader {
+public:
+
+    binary_reader(const char* data, std::size_t size);
+
+    virtual ~binary_reader();
+
+    /**
+     * Returns a pointer to the next size bytes and skips them
+     */
+    const char* read(std::size_t size);
+
+    template<typename T>
+    T read_value()
+    {
+        static_assert(std::is_pod<T>::value, "T is not a POD type");
+        T value;
+        std::memcpy(&value, read(sizeof(T)), sizeof(T));
+        return value;
+    }
+
+    /**
+     * Skips bytes until the offset is a multiple of alignment
+     */
+    void align(std::size_t alignment);
+
+    std::size_t offset() const;
+
+    binary_reader(const binary_reader&) = delete;
+    binary_reader& operator=(const binary_reader&) = delete;
+    binary_reader(binary_reader&&) = delete;
+    binary_reader& operator=(binary_reader&&) = delete;
+
+protected:
+    const char* data_;
+    const std::size_t size_;
+    std::size_t offset_;
+};
+
+
+/**
+ * Writes the header of the binary format: a magic string, the format
+ * version, the size of the element type and a byte order mark
+ */
+void write_header(densitas::core::binary_writer& writer, std::size_t element_size);
+
+/**
+ * Reads and checks the header written by write_header() and returns the
+ * format version. Throws a densitas_error if the data was not written by
+ * densitas, by a newer version of the format, for another element type or
+ * byte order
+ */
+std::uint32_t read_header(densitas::core::binary_reader& reader, std::size_t element_size);
+
+
+/**
+ * A read-only view of a file's contents. The file is memory-mapped where
+ * supported so its pages are only loaded when accessed, otherwise it is
+ * read into memory. The mapping is private, so writes to it never reach
+ * the file. The data is aligned to at least 64 bytes
+ */
+class mapped_file {
+public:
+
+    explicit
+    mapped_file(const std::string& filename);
+
+    virtual ~mapped_file();
+
+    const char* data() const;
+
+    std::size_t size() const;
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+    mapped_file(mapped_file&&) = delete;
+    mapped_file& operator=(mapped_file&&) = delete;
+
+protected:
+    char* data_;
+    std::size_t size_;
+    bool mapped_;
+    std::vector<char> buffer_;
+};
+
+
+} // core
+} // densitas
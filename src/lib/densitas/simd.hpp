@@ -0,0 +1,187 @@
+#pragma once
+#include <cstddef>
+#include <limits>
+
+
+namespace densitas {
+namespace simd {
+
+/**
+ * The instruction sets the kernels are implemented for, from worst to best
+ */
+enum class instruction_set {
+    scalar,
+    sse2,
+    avx2,
+    avx512
+};
+
+/**
+ * Returns the best instruction set supported by both this build of the
+ * library and the CPU. Always scalar if the library was compiled with
+ * DENSITAS_NO_SIMD defined
+ */
+densitas::simd::instruction_set supported_instruction_set();
+
+/**
+ * Returns the instruction set the kernels currently dispatch to. This is
+ * the supported instruction set unless changed by use_instruction_set()
+ */
+densitas::simd::instruction_set active_instruction_set();
+
+/**
+ * Makes the kernels dispatch to the given instruction set or to the
+ * supported one if the given one is not supported. Returns the instruction
+ * set now in use. All instruction sets produce identical results
+ */
+densitas::simd::instruction_set use_instruction_set(densitas::simd::instruction_set set);
+
+
+namespace scalar {
+
+/**
+ * The number of partial sums of positive_sum(). Element i is added to
+ * partial sum i modulo this number so that every instruction set sums
+ * in the same order
+ */
+template<typename ElementType>
+constexpr std::size_t n_partial_sums()
+{
+    return sizeof(ElementType) < 64 ? 64 / sizeof(ElementType) : 1;
+}
+
+/**
+ * Adds up the partial sums pairwise and returns the total
+ */
+template<typename ElementType>
+ElementType sum_partial_sums(ElementType* partial)
+{
+    for (std::size_t width=densitas::simd::scalar::n_partial_sums<ElementType>()/2; width>0; width/=2) {
+        for (std::size_t k=0; k<width; ++k) {
+            partial[k] += partial[k + width];
+        }
+    }
+    return partial[0];
+}
+
+template<typename ElementType>
+ElementType minimum(const ElementType* data, std::size_t n)
+{
+    auto minimum = std::numeric_limits<ElementType>::max();
+    for (std::size_t i=0; i<n; ++i) {
+        if (data[i] < minimum)
+            minimum = data[i];
+    }
+    return minimum;
+}
+
+template<typename ElementType>
+ElementType positive_sum(const ElementType* data, std::size_t n)
+{
+    const auto n_partial = densitas::simd::scalar::n_partial_sums<ElementType>();
+    ElementType partial[n_partial] = {};
+    for (std::size_t i=0; i<n; ++i) {
+        if (data[i] > 0)
+            partial[i % n_partial] += data[i];
+    }
+    return densitas::simd::scalar::sum_partial_sums(partial);
+}
+
+template<typename ElementType>
+void classification_target(const ElementType* values, std::size_t n, ElementType lower, ElementType upper, ElementType yes, ElementType no, ElementType* target)
+{
+    for (std::size_t i=0; i<n; ++i) {
+        target[i] = values[i]<lower || values[i]>upper ? no : yes;
+    }
+}
+
+template<typename ElementType>
+void linspace(ElementType start, ElementType delta, std::size_t n, ElementType* target)
+{
+    for (std::size_t i=0; i<n; ++i) {
+        target[i] = start + static_cast<ElementType>(i)*delta;
+    }
+}
+
+template<typename ElementType>
+void counts(const ElementType* weights, std::size_t n, ElementType divisor, std::size_t* counts)
+{
+    for (std::size_t i=0; i<n; ++i) {
+        counts[i] = static_cast<std::size_t>(weights[i] / divisor);
+    }
+}
+
+} // scalar
+
+
+/**
+ * Returns the smallest element or the largest ElementType if there are no
+ * elements. NaNs are ignored
+ */
+template<typename ElementType>
+ElementType minimum(const ElementType* data, std::size_t n)
+{
+    return densitas::simd::scalar::minimum(data, n);
+}
+
+float minimum(const float* data, std::size_t n);
+
+double minimum(const double* data, std::size_t n);
+
+/**
+ * Returns the sum of the positive elements
+ */
+template<typename ElementType>
+ElementType positive_sum(const ElementType* data, std::size_t n)
+{
+    return densitas::simd::scalar::positive_sum(data, n);
+}
+
+float positive_sum(const float* data, std::size_t n);
+
+double positive_sum(const double* data, std::size_t n);
+
+/**
+ * Sets target[i] to no if values[i] is outside of [lower, upper] and to
+ * yes otherwise
+ */
+template<typename ElementType>
+void classification_target(const ElementType* values, std::size_t n, ElementType lower, ElementType upper, ElementType yes, ElementType no, ElementType* target)
+{
+    densitas::simd::scalar::classification_target(values, n, lower, upper, yes, no, target);
+}
+
+void classification_target(const float* values, std::size_t n, float lower, float upper, float yes, float no, float* target);
+
+void classification_target(const double* values, std::size_t n, double lower, double upper, double yes, double no, double* target);
+
+/**
+ * Sets target[i] to start + i*delta
+ */
+template<typename ElementType>
+void linspace(ElementType start, ElementType delta, std::size_t n, ElementType* target)
+{
+    densitas::simd::scalar::linspace(start, delta, n, target);
+}
+
+void linspace(float start, float delta, std::size_t n, float* target);
+
+void linspace(double start, double delta, std::size_t n, double* target);
+
+/**
+ * Sets counts[i] to weights[i] / divisor rounded towards zero. The
+ * quotients must be representable as std::size_t
+ */
+template<typename ElementType>
+void counts(const ElementType* weights, std::size_t n, ElementType divisor, std::size_t* counts)
+{
+    densitas::simd::scalar::counts(weights, n, divisor, counts);
+}
+
+void counts(const float* weights, std::size_t n, float divisor, std::size_t* counts);
+
+void counts(const double* weights, std::size_t n, double divisor, std::size_t* counts);
+
+
+} // simd
+} // densitas
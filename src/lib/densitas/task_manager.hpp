@@ -1,10 +1,18 @@
 #pragma once
+#include "densitas_error.hpp"
 #include <thread>
 #include <memory>
 #include <atomic>
 #include <list>
+#include <deque>
+#include <vector>
 #include <mutex>
 #include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <type_traits>
+#include <exception>
+#include <future>
 
 
 namespace densitas {
@@ -56,19 +64,105 @@ private:
 };
 
 
+/**
+ * A long-lived pool of worker threads executing jobs in FIFO order.
+ * Threads are only ever added, never removed, until the pool is destroyed
+ */
+class thread_pool {
+public:
+
+    explicit
+    thread_pool(std::size_t n_threads=0);
+
+    virtual ~thread_pool();
+
+    void push(std::function<void()> job);
+
+    void reserve(std::size_t n_threads);
+
+    std::size_t n_threads() const;
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+    thread_pool(thread_pool&&) = delete;
+    thread_pool& operator=(thread_pool&&) = delete;
+
+protected:
+    bool done_;
+    std::deque<std::function<void()>> jobs_;
+    std::vector<std::thread> threads_;
+    mutable std::mutex mutex_;
+    std::condition_variable cond_var_;
+
+    void worker();
+};
+
+
+/**
+ * Returns the thread pool shared by all task managers that are not
+ * given a pool explicitly. It is created on first use
+ */
+densitas::core::thread_pool& default_thread_pool();
+
+
+/**
+ * Returns the thread pool running the jobs launched by launch_async unless
+ * given another one. It is created on first use with one thread per core
+ */
+densitas::core::thread_pool& async_thread_pool();
+
+
+/**
+ * Runs functor() as a single job on the given pool and returns a future
+ * of its result or exception. Since the functor may itself wait for tasks
+ * on the default thread pool, running it there could exhaust the pool with
+ * waiting jobs, so the default thread pool is rejected
+ */
+template<typename Functor>
+std::future<typename std::result_of<Functor()>::type> launch_async(densitas::core::thread_pool& pool, Functor&& functor)
+{
+    if (&pool == &densitas::core::default_thread_pool())
+        throw densitas::densitas_error("asynchronous jobs cannot run on the default thread pool");
+    typedef typename std::result_of<Functor()>::type result_type;
+    auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<Functor>(functor));
+    auto future = task->get_future();
+    pool.reserve(1);
+    pool.push([task]() { (*task)(); });
+    return future;
+}
+
+
 struct task {
-    task(std::shared_ptr<std::atomic_bool> done, std::thread&& thread);
+    explicit
+    task(std::shared_ptr<std::atomic_bool> done);
     std::shared_ptr<std::atomic_bool> done;
-    std::thread thread;
 };
 
 
+struct pool_job {
+    std::function<void()> job;
+    // keeps the condition variable alive until the job has returned
+    std::shared_ptr<densitas::core::condition_variable> cond_var;
+
+    void operator()() const
+    {
+        job();
+    }
+};
+
+
+/**
+ * Runs at most max_tasks tasks at a time on a thread pool and waits
+ * for all of its tasks to finish when destroyed
+ */
 class task_manager {
 public:
 
     explicit
     task_manager(int max_tasks);
 
+    task_manager(int max_tasks, densitas::core::thread_pool& pool);
+
     virtual ~task_manager();
 
     void wait_for_slot();
@@ -78,8 +172,10 @@ public:
     {
         wait_for_slot();
         auto done = std::make_shared<std::atomic_bool>(false);
-        auto runner = densitas::core::functor_runner<>{done, cond_var_};
-        tasks_.emplace_back(done, std::thread{std::move(runner), std::forward<Functor>(functor), std::forward<Args>(args)...});
+        auto runner = densitas::core::functor_runner<>{done, *cond_var_};
+        std::function<void()> job = std::bind(std::move(runner), std::forward<Functor>(functor), std::forward<Args>(args)...);
+        tasks_.emplace_back(done);
+        pool_.push(densitas::core::pool_job{std::move(job), cond_var_});
     }
 
     task_manager(const task_manager&) = delete;
@@ -90,9 +186,111 @@ public:
 protected:
     const std::size_t max_tasks_;
     std::list<densitas::core::task> tasks_;
-    densitas::core::condition_variable cond_var_;
+    std::shared_ptr<densitas::core::condition_variable> cond_var_;
+    densitas::core::thread_pool& pool_;
+
+    void remove_finished();
 };
 
 
+struct index_range {
+    std::size_t begin;
+    std::size_t end;
+};
+
+
+/**
+ * Hands out contiguous ranges of [0, n_items) to workers that ask for them.
+ * Ranges shrink as fewer items remain (guided scheduling) so that workers
+ * finishing early pick up the tail of the work
+ */
+class range_dispenser {
+public:
+
+    range_dispenser(std::size_t n_items, std::size_t n_workers, std::size_t min_chunk=1);
+
+    virtual ~range_dispenser();
+
+    bool next(densitas::core::index_range& range);
+
+    void stop();
+
+    range_dispenser(const range_dispenser&) = delete;
+    range_dispenser& operator=(const range_dispenser&) = delete;
+    range_dispenser(range_dispenser&&) = delete;
+    range_dispenser& operator=(range_dispenser&&) = delete;
+
+protected:
+    const std::size_t n_items_;
+    const std::size_t n_workers_;
+    const std::size_t min_chunk_;
+    std::atomic<std::size_t> position_;
+};
+
+
+template<typename Functor>
+class range_worker {
+public:
+
+    range_worker(Functor& functor, densitas::core::range_dispenser& dispenser, std::exception_ptr& error, std::mutex& error_mutex)
+    : functor_(functor), dispenser_(dispenser), error_(error), error_mutex_(error_mutex)
+    {}
+
+    void operator()(std::size_t worker_index)
+    {
+        try {
+            densitas::core::index_range range{0, 0};
+            while (dispenser_.next(range)) {
+                functor_(worker_index, range.begin, range.end);
+            }
+        } catch (...) {
+            dispenser_.stop();
+            std::lock_guard<std::mutex> lock{error_mutex_};
+            if (!error_) error_ = std::current_exception();
+        }
+    }
+
+private:
+    Functor& functor_;
+    densitas::core::range_dispenser& dispenser_;
+    std::exception_ptr& error_;
+    std::mutex& error_mutex_;
+};
+
+
+/**
+ * Calls functor(worker_index, begin, end) for contiguous ranges covering
+ * [0, n_items) using up to the given number of threads, one of which is the
+ * calling thread. Every worker pulls new ranges as soon as it is done with
+ * its current one. Ranges are at least min_chunk items long except for the
+ * last one. The first exception thrown by the functor is rethrown once all
+ * workers have finished
+ */
+template<typename Functor>
+void parallel_for(std::size_t n_items, int threads, Functor&& functor, std::size_t min_chunk=1)
+{
+    if (!n_items)
+        return;
+    if (threads <= 1) {
+        functor(0, 0, n_items);
+        return;
+    }
+    const auto n_workers = std::min(static_cast<std::size_t>(threads), n_items);
+    densitas::core::range_dispenser dispenser{n_items, n_workers, min_chunk};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    densitas::core::range_worker<typename std::remove_reference<Functor>::type> worker{functor, dispenser, error, error_mutex};
+    {
+        densitas::core::task_manager manager(static_cast<int>(n_workers - 1));
+        for (std::size_t i=1; i<n_workers; ++i) {
+            manager.launch_new(std::ref(worker), i);
+        }
+        worker(0);
+    }
+    if (error)
+        std::rethrow_exception(error);
+}
+
+
 } // core
 } // densitas
@@ -0,0 +1,108 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <ostream>
+#include <utility>
+#include <initializer_list>
+
+
+namespace densitas {
+
+
+/**
+ * Records timed events such as the tasks run while training and predicting
+ * and writes them in the Chrome trace-event JSON format, which can be
+ * viewed in chrome://tracing or Perfetto. Events show up per thread. All
+ * methods are thread-safe
+ */
+class tracer {
+public:
+
+    typedef std::vector<std::pair<std::string, std::size_t>> arguments;
+
+    tracer();
+
+    virtual ~tracer();
+
+    /**
+     * Returns the microseconds elapsed since construction
+     */
+    double now() const;
+
+    /**
+     * Records an event of the calling thread from begin to end, both in
+     * microseconds as returned by now()
+     */
+    void record(const std::string& name, const std::string& category, double begin, double end, const densitas::tracer::arguments& args={});
+
+    std::size_t n_events() const;
+
+    void clear();
+
+    /**
+     * Writes the events recorded so far as a JSON object
+     */
+    void write(std::ostream& stream) const;
+
+    /**
+     * Writes the events recorded so far to a file, see write()
+     */
+    void save(const std::string& filename) const;
+
+    tracer(const tracer&) = delete;
+    tracer& operator=(const tracer&) = delete;
+    tracer(tracer&&) = delete;
+    tracer& operator=(tracer&&) = delete;
+
+protected:
+
+    struct event {
+        std::string name;
+        std::string category;
+        double begin;
+        double duration;
+        std::size_t thread;
+        densitas::tracer::arguments args;
+    };
+
+    const std::chrono::steady_clock::time_point start_;
+    mutable std::mutex mutex_;
+    std::vector<event> events_;
+    std::map<std::thread::id, std::size_t> threads_;
+};
+
+
+namespace core {
+
+
+/**
+ * Records an event spanning its own lifetime if given a tracer, otherwise
+ * does nothing
+ */
+class trace_scope {
+public:
+
+    trace_scope(densitas::tracer* tracer, const char* name, const char* category, std::initializer_list<std::pair<const char*, std::size_t>> args={});
+
+    virtual ~trace_scope();
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+    trace_scope(trace_scope&&) = delete;
+    trace_scope& operator=(trace_scope&&) = delete;
+
+protected:
+    densitas::tracer* tracer_;
+    const char* name_;
+    const char* category_;
+    densitas::tracer::arguments args_;
+    double begin_;
+};
+
+
+} // core
+} // densitas
@@ -1,8 +1,48 @@
 #pragma once
 #include "type_check.hpp"
+#include <cstddef>
+#include <type_traits>
 
 
 namespace densitas {
+namespace core {
+
+
+template<typename ElementType, typename ObjectType>
+auto memptr(ObjectType& object, int) -> decltype(static_cast<ElementType*>(object.memptr()))
+{
+    return object.memptr();
+}
+
+template<typename ElementType, typename ObjectType>
+ElementType* memptr(ObjectType&, ...)
+{
+    return nullptr;
+}
+
+
+template<typename ElementType, typename ObjectType>
+auto memory_pointer(ObjectType& object, int) -> decltype(static_cast<ElementType*>(object.memptr()))
+{
+    return object.memptr();
+}
+
+template<typename ElementType, typename ObjectType>
+auto memory_pointer(ObjectType& object, long) -> decltype(static_cast<ElementType*>(object.data()))
+{
+    return object.data();
+}
+
+template<typename ElementType, typename ObjectType>
+ElementType* memory_pointer(ObjectType&, ...)
+{
+    return nullptr;
+}
+
+
+} // core
+
+
 namespace vector_adapter {
 
 /**
@@ -43,6 +83,112 @@ void set_element(VectorType& vector, std::size_t index, ElementType value)
     vector(index) = value;
 }
 
+/**
+ * Declares whether the vector exposes its contiguous elements through a
+ * memptr() or data() method like armadillo or std::vector. Only then the
+ * default data() uses that memory, bypassing get_element and set_element.
+ * Defaults to false, specialize this deriving from std::true_type to
+ * enable it
+ */
+template<typename VectorType>
+struct contiguous_memory : std::false_type {};
+
+/**
+ * Returns a pointer to the contiguous elements of the vector or nullptr if
+ * the vector does not store its elements contiguously. If available, the
+ * pointer is used for bulk access instead of get_element. By default, the
+ * pointer of a memptr() or data() method returning a pointer to ElementType
+ * is used if contiguous_memory is true for the vector
+ */
+template<typename ElementType, typename VectorType>
+const ElementType* data(const VectorType& vector)
+{
+    densitas::core::check_element_type<ElementType>();
+    return densitas::vector_adapter::contiguous_memory<VectorType>::value ? densitas::core::memory_pointer<const ElementType>(vector, 0) : nullptr;
+}
+
+/**
+ * Returns a pointer to the contiguous, mutable elements of the vector or
+ * nullptr if the vector does not store its elements contiguously. If
+ * available, the pointer is used for bulk access instead of set_element.
+ * Detected by default like data()
+ */
+template<typename ElementType, typename VectorType>
+ElementType* mutable_data(VectorType& vector)
+{
+    densitas::core::check_element_type<ElementType>();
+    return densitas::vector_adapter::contiguous_memory<VectorType>::value ? densitas::core::memory_pointer<ElementType>(vector, 0) : nullptr;
+}
+
+/**
+ * Constructs a new vector holding the n_elem elements at data. This copies
+ * the elements by default. Specialize this to return a vector using the
+ * memory in place if your vector type supports it. When loading a density
+ * estimator, data points into memory that stays valid as long as the
+ * density estimator and its clones are alive
+ */
+template<typename VectorType, typename ElementType>
+VectorType construct_from_memory(const ElementType* data, std::size_t n_elem)
+{
+    densitas::core::check_element_type<ElementType>();
+    auto vector = densitas::vector_adapter::construct_uninitialized<VectorType>(n_elem);
+    const auto target = densitas::vector_adapter::mutable_data<ElementType>(vector);
+    for (std::size_t i=0; i<n_elem; ++i) {
+        if (target)
+            target[i] = data[i];
+        else
+            densitas::vector_adapter::set_element<ElementType>(vector, i, data[i]);
+    }
+    return vector;
+}
+
 
 } // vector_adapter
+
+
+namespace core {
+
+
+/**
+ * Calls functor(index, value) for the elements in [begin, end) of the
+ * vector. The elements are read through vector_adapter::data() if available
+ * so the choice between the two paths is made once per call
+ */
+template<typename ElementType, typename VectorType, typename Functor>
+void for_each_element(const VectorType& vector, std::size_t begin, std::size_t end, Functor&& functor)
+{
+    const auto data = densitas::vector_adapter::data<ElementType>(vector);
+    if (data) {
+        for (std::size_t i=begin; i<end; ++i) {
+            functor(i, data[i]);
+        }
+    } else {
+        for (std::size_t i=begin; i<end; ++i) {
+            functor(i, densitas::vector_adapter::get_element<ElementType>(vector, i));
+        }
+    }
+}
+
+
+/**
+ * Sets the elements in [begin, end) of the vector to functor(index). The
+ * elements are written through vector_adapter::mutable_data() if available
+ */
+template<typename ElementType, typename VectorType, typename Functor>
+void generate_elements(VectorType& vector, std::size_t begin, std::size_t end, Functor&& functor)
+{
+    const auto data = densitas::vector_adapter::mutable_data<ElementType>(vector);
+    if (data) {
+        for (std::size_t i=begin; i<end; ++i) {
+            data[i] = functor(i);
+        }
+    } else {
+        for (std::size_t i=begin; i<end; ++i) {
+            densitas::vector_adapter::set_element<ElementType>(vector, i, functor(i));
+        }
+    }
+}
+
+
+} // core
 } // densitas
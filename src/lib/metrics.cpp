@@ -0,0 +1,164 @@
+#include "densitas/metrics.hpp"
+
+
+namespace densitas {
+
+
+namespace {
+
+densitas::metrics::summary empty_summary()
+{
+    densitas::metrics::summary summary;
+    summary.count = 0;
+    summary.total_seconds = 0;
+    summary.min_seconds = 0;
+    summary.max_seconds = 0;
+    summary.histogram.fill(0);
+    return summary;
+}
+
+void add(densitas::metrics::summary& summary, double seconds)
+{
+    if (!summary.count || seconds < summary.min_seconds)
+        summary.min_seconds = seconds;
+    if (!summary.count || seconds > summary.max_seconds)
+        summary.max_seconds = seconds;
+    ++summary.count;
+    summary.total_seconds += seconds;
+    ++summary.histogram[densitas::metrics::bucket(seconds)];
+}
+
+void add(densitas::metrics::summary& summary, const densitas::metrics::summary& other)
+{
+    if (!other.count)
+        return;
+    if (!summary.count || other.min_seconds < summary.min_seconds)
+        summary.min_seconds = other.min_seconds;
+    if (!summary.count || other.max_seconds > summary.max_seconds)
+        summary.max_seconds = other.max_seconds;
+    summary.count += other.count;
+    summary.total_seconds += other.total_seconds;
+    for (std::size_t k=0; k<densitas::metrics::n_buckets; ++k) {
+        summary.histogram[k] += other.histogram[k];
+    }
+}
+
+std::size_t index(densitas::metrics::phase phase)
+{
+    return static_cast<std::size_t>(phase);
+}
+
+} // anonymous
+
+
+const std::size_t metrics::n_phases;
+
+const std::size_t metrics::n_buckets;
+
+metrics::metrics()
+: mutex_{}, phases_{}, models_{}
+{
+    phases_.fill(empty_summary());
+}
+
+metrics::~metrics()
+{}
+
+void metrics::record(densitas::metrics::phase phase, double seconds)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    add(phases_[index(phase)], seconds);
+}
+
+void metrics::record(densitas::metrics::phase phase, std::size_t model_index, double seconds)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    add(phases_[index(phase)], seconds);
+    auto& models = models_[index(phase)];
+    if (model_index >= models.size())
+        models.resize(model_index + 1, empty_summary());
+    add(models[model_index], seconds);
+}
+
+void metrics::merge(const densitas::metrics& other)
+{
+    if (&other == this)
+        return;
+    std::array<densitas::metrics::summary, n_phases> phases;
+    std::array<std::vector<densitas::metrics::summary>, n_phases> models;
+    {
+        std::lock_guard<std::mutex> lock{other.mutex_};
+        phases = other.phases_;
+        models = other.models_;
+    }
+    std::lock_guard<std::mutex> lock{mutex_};
+    for (std::size_t p=0; p<n_phases; ++p) {
+        add(phases_[p], phases[p]);
+        if (models[p].size() > models_[p].size())
+            models_[p].resize(models[p].size(), empty_summary());
+        for (std::size_t i=0; i<models[p].size(); ++i) {
+            add(models_[p][i], models[p][i]);
+        }
+    }
+}
+
+void metrics::reset()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    phases_.fill(empty_summary());
+    for (auto& models : models_) {
+        models.clear();
+    }
+}
+
+densitas::metrics::summary metrics::get(densitas::metrics::phase phase) const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return phases_[index(phase)];
+}
+
+densitas::metrics::summary metrics::get(densitas::metrics::phase phase, std::size_t model_index) const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto& models = models_[index(phase)];
+    return model_index < models.size() ? models[model_index] : empty_summary();
+}
+
+std::size_t metrics::n_models(densitas::metrics::phase phase) const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return models_[index(phase)].size();
+}
+
+std::size_t metrics::bucket(double seconds)
+{
+    double upper = 1e-6;
+    std::size_t bucket = 0;
+    while (!(seconds < upper) && bucket < n_buckets - 1) {
+        upper *= 2;
+        ++bucket;
+    }
+    return bucket;
+}
+
+
+namespace core {
+
+
+stopwatch::stopwatch(bool enabled)
+: enabled_{enabled}, start_{}
+{
+    if (enabled_)
+        start_ = std::chrono::steady_clock::now();
+}
+
+double stopwatch::seconds() const
+{
+    if (!enabled_)
+        return 0;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+
+} // core
+} // densitas
@@ -0,0 +1,172 @@
+#include "densitas/serialization.hpp"
+#include <fstream>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define DENSITAS_HAS_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+namespace densitas {
+namespace core {
+
+
+namespace {
+
+const char magic[8] = {'D', 'E', 'N', 'S', 'I', 'T', 'A', 'S'};
+
+const std::uint32_t byte_order_mark = 0x01020304;
+
+#ifndef DENSITAS_HAS_MMAP
+const std::size_t data_alignment = 64;
+#endif
+
+} // anonymous
+
+
+binary_writer::binary_writer(std::ostream& stream)
+: stream_(stream), offset_{0}
+{}
+
+binary_writer::~binary_writer()
+{}
+
+void binary_writer::write(const void* data, std::size_t size)
+{
+    stream_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    if (!stream_)
+        throw densitas::densitas_error("failed writing to stream at offset: " + std::to_string(offset_));
+    offset_ += size;
+}
+
+void binary_writer::align(std::size_t alignment)
+{
+    const char zeros[64] = {};
+    while (offset_ % alignment) {
+        const auto padding = std::min(alignment - offset_ % alignment, sizeof(zeros));
+        write(zeros, padding);
+    }
+}
+
+std::size_t binary_writer::offset() const
+{
+    return offset_;
+}
+
+
+binary_reader::binary_reader(const char* data, std::size_t size)
+: data_{data}, size_{size}, offset_{0}
+{}
+
+binary_reader::~binary_reader()
+{}
+
+const char* binary_reader::read(std::size_t size)
+{
+    if (size > size_ - offset_)
+        throw densitas::densitas_error("unexpected end of data at offset: " + std::to_string(offset_));
+    const auto data = data_ + offset_;
+    offset_ += size;
+    return data;
+}
+
+void binary_reader::align(std::size_t alignment)
+{
+    if (offset_ % alignment)
+        read(alignment - offset_ % alignment);
+}
+
+std::size_t binary_reader::offset() const
+{
+    return offset_;
+}
+
+
+void write_header(densitas::core::binary_writer& writer, std::size_t element_size)
+{
+    writer.write(magic, sizeof(magic));
+    writer.write_value(densitas::core::serialization_format_version);
+    writer.write_value(static_cast<std::uint32_t>(element_size));
+    writer.write_value(byte_order_mark);
+    writer.write_value(std::uint32_t{0});
+}
+
+std::uint32_t read_header(densitas::core::binary_reader& reader, std::size_t element_size)
+{
+    if (std::memcmp(reader.read(sizeof(magic)), magic, sizeof(magic)) != 0)
+        throw densitas::densitas_error("data was not written by densitas");
+    const auto version = reader.read_value<std::uint32_t>();
+    if (version < 1 || version > densitas::core::serialization_format_version)
+        throw densitas::densitas_error("unsupported format version: " + std::to_string(version));
+    const auto size = reader.read_value<std::uint32_t>();
+    if (size != element_size)
+        throw densitas::densitas_error("element size not matching: " + std::to_string(size));
+    if (reader.read_value<std::uint32_t>() != byte_order_mark)
+        throw densitas::densitas_error("byte order not matching");
+    reader.read_value<std::uint32_t>();
+    return version;
+}
+
+
+mapped_file::mapped_file(const std::string& filename)
+: data_{nullptr}, size_{0}, mapped_{false}, buffer_{}
+{
+#ifdef DENSITAS_HAS_MMAP
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        throw densitas::densitas_error("cannot open file: " + filename);
+    struct stat status;
+    if (::fstat(fd, &status) != 0) {
+        ::close(fd);
+        throw densitas::densitas_error("cannot stat file: " + filename);
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    if (size_ > 0) {
+        void* data = ::mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            throw densitas::densitas_error("cannot map file: " + filename);
+        }
+        data_ = static_cast<char*>(data);
+        mapped_ = true;
+    }
+    ::close(fd);
+#else
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file)
+        throw densitas::densitas_error("cannot open file: " + filename);
+    size_ = static_cast<std::size_t>(file.tellg());
+    buffer_.resize(size_ + data_alignment);
+    const auto address = reinterpret_cast<std::uintptr_t>(buffer_.data());
+    data_ = buffer_.data() + (data_alignment - address % data_alignment) % data_alignment;
+    file.seekg(0);
+    if (!file.read(data_, static_cast<std::streamsize>(size_)))
+        throw densitas::densitas_error("cannot read file: " + filename);
+#endif
+}
+
+mapped_file::~mapped_file()
+{
+#ifdef DENSITAS_HAS_MMAP
+    if (mapped_)
+        ::munmap(data_, size_);
+#endif
+}
+
+const char* mapped_file::data() const
+{
+    return data_;
+}
+
+std::size_t mapped_file::size() const
+{
+    return size_;
+}
+
+
+} // core
+} // densitas
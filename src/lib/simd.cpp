@@ -0,0 +1,485 @@
+#include "densitas/simd.hpp"
+#include <atomic>
+#include <algorithm>
+
+#if !defined(DENSITAS_NO_SIMD) && (defined(__x86_64__) || defined(__i386__)) && !defined(__INTEL_COMPILER) && \
+    ((defined(__clang__) && (__clang_major__ > 3 || (__clang_major__ == 3 && __clang_minor__ >= 9))) || \
+     (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#define DENSITAS_SIMD_X86
+#if defined(__clang__) || __GNUC__ >= 6
+#define DENSITAS_SIMD_AVX512
+#endif
+#endif
+
+#ifdef DENSITAS_SIMD_X86
+#include <immintrin.h>
+#define DENSITAS_TARGET(isa) __attribute__((target(isa)))
+#define DENSITAS_ALWAYS_INLINE inline __attribute__((always_inline))
+#endif
+
+
+namespace densitas {
+namespace simd {
+namespace {
+
+
+densitas::simd::instruction_set detect_instruction_set()
+{
+#ifdef DENSITAS_SIMD_X86
+#if !defined(__clang__)
+    __builtin_cpu_init();
+#endif
+#ifdef DENSITAS_SIMD_AVX512
+    if (__builtin_cpu_supports("avx512f"))
+        return densitas::simd::instruction_set::avx512;
+#endif
+    if (__builtin_cpu_supports("avx2"))
+        return densitas::simd::instruction_set::avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return densitas::simd::instruction_set::sse2;
+#endif
+    return densitas::simd::instruction_set::scalar;
+}
+
+
+std::atomic<densitas::simd::instruction_set>& active_set()
+{
+    static std::atomic<densitas::simd::instruction_set> set{densitas::simd::supported_instruction_set()};
+    return set;
+}
+
+
+#ifdef DENSITAS_SIMD_X86
+
+/*
+ * The kernels are written once against an Ops type wrapping the intrinsics
+ * of one instruction set and element type. Ops::width elements are
+ * processed at a time, the remainder by the scalar code
+ */
+namespace kernels {
+
+
+// the kernels pass vector types around without being compiled for an
+// instruction set themselves but are always inlined into functions that
+// are, so the ABI warning does not apply
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+
+template<typename Ops, typename ElementType>
+DENSITAS_ALWAYS_INLINE
+ElementType minimum(const ElementType* data, std::size_t n)
+{
+    // the second operand is returned for NaNs so NaNs in data are ignored
+    auto accumulator = Ops::set1(std::numeric_limits<ElementType>::max());
+    std::size_t i = 0;
+    for (; i + Ops::width <= n; i += Ops::width) {
+        accumulator = Ops::min(Ops::load(data + i), accumulator);
+    }
+    ElementType lanes[Ops::width];
+    Ops::store(lanes, accumulator);
+    auto minimum = densitas::simd::scalar::minimum(lanes, Ops::width);
+    const auto rest = densitas::simd::scalar::minimum(data + i, n - i);
+    return rest < minimum ? rest : minimum;
+}
+
+
+template<typename Ops, typename ElementType>
+DENSITAS_ALWAYS_INLINE
+ElementType positive_sum(const ElementType* data, std::size_t n)
+{
+    const auto n_partial = densitas::simd::scalar::n_partial_sums<ElementType>();
+    const auto n_regs = n_partial / Ops::width;
+    const auto zero = Ops::zero();
+    typename Ops::reg accumulators[n_regs];
+    for (std::size_t r=0; r<n_regs; ++r) {
+        accumulators[r] = zero;
+    }
+    std::size_t i = 0;
+    for (; i + n_partial <= n; i += n_partial) {
+        for (std::size_t r=0; r<n_regs; ++r) {
+            accumulators[r] = Ops::add(accumulators[r], Ops::max(Ops::load(data + i + r*Ops::width), zero));
+        }
+    }
+    ElementType partial[n_partial];
+    for (std::size_t r=0; r<n_regs; ++r) {
+        Ops::store(partial + r*Ops::width, accumulators[r]);
+    }
+    for (std::size_t k=0; i + k<n; ++k) {
+        if (data[i + k] > 0)
+            partial[k] += data[i + k];
+    }
+    return densitas::simd::scalar::sum_partial_sums(partial);
+}
+
+
+template<typename Ops, typename ElementType>
+DENSITAS_ALWAYS_INLINE
+void classification_target(const ElementType* values, std::size_t n, ElementType lower, ElementType upper, ElementType yes, ElementType no, ElementType* target)
+{
+    const auto lower_reg = Ops::set1(lower);
+    const auto upper_reg = Ops::set1(upper);
+    const auto yes_reg = Ops::set1(yes);
+    const auto no_reg = Ops::set1(no);
+    std::size_t i = 0;
+    for (; i + Ops::width <= n; i += Ops::width) {
+        Ops::store(target + i, Ops::select_outside(Ops::load(values + i), lower_reg, upper_reg, no_reg, yes_reg));
+    }
+    densitas::simd::scalar::classification_target(values + i, n - i, lower, upper, yes, no, target + i);
+}
+
+
+template<typename Ops, typename ElementType>
+DENSITAS_ALWAYS_INLINE
+void linspace(ElementType start, ElementType delta, std::size_t n, ElementType* target)
+{
+    ElementType offsets[Ops::width];
+    for (std::size_t l=0; l<Ops::width; ++l) {
+        offsets[l] = static_cast<ElementType>(l);
+    }
+    const auto offsets_reg = Ops::load(offsets);
+    const auto start_reg = Ops::set1(start);
+    const auto delta_reg = Ops::set1(delta);
+    std::size_t i = 0;
+    for (; i + Ops::width <= n; i += Ops::width) {
+        const auto indices = Ops::add(Ops::set1(static_cast<ElementType>(i)), offsets_reg);
+        Ops::store(target + i, Ops::add(start_reg, Ops::mul(indices, delta_reg)));
+    }
+    // the remainder is computed with vectors, too, as scalar code compiled
+    // for an instruction set with fma might be contracted
+    if (i < n) {
+        const auto indices = Ops::add(Ops::set1(static_cast<ElementType>(i)), offsets_reg);
+        Ops::store(offsets, Ops::add(start_reg, Ops::mul(indices, delta_reg)));
+        std::copy(offsets, offsets + (n - i), target + i);
+    }
+}
+
+
+template<typename Ops, typename ElementType>
+DENSITAS_ALWAYS_INLINE
+void counts(const ElementType* weights, std::size_t n, ElementType divisor, std::size_t* counts)
+{
+    const auto divisor_reg = Ops::set1(divisor);
+    ElementType quotients[Ops::width];
+    std::size_t i = 0;
+    for (; i + Ops::width <= n; i += Ops::width) {
+        Ops::store(quotients, Ops::div(Ops::load(weights + i), divisor_reg));
+        for (std::size_t l=0; l<Ops::width; ++l) {
+            counts[i + l] = static_cast<std::size_t>(quotients[l]);
+        }
+    }
+    densitas::simd::scalar::counts(weights + i, n - i, divisor, counts + i);
+}
+
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+
+} // kernels
+
+
+#define DENSITAS_DEFINE_ENTRY_POINTS(isa) \
+template<typename ElementType> \
+DENSITAS_TARGET(isa) \
+ElementType minimum(const ElementType* data, std::size_t n) \
+{ \
+    return densitas::simd::kernels::minimum<ops<ElementType>>(data, n); \
+} \
+template<typename ElementType> \
+DENSITAS_TARGET(isa) \
+ElementType positive_sum(const ElementType* data, std::size_t n) \
+{ \
+    return densitas::simd::kernels::positive_sum<ops<ElementType>>(data, n); \
+} \
+template<typename ElementType> \
+DENSITAS_TARGET(isa) \
+void classification_target(const ElementType* values, std::size_t n, ElementType lower, ElementType upper, ElementType yes, ElementType no, ElementType* target) \
+{ \
+    densitas::simd::kernels::classification_target<ops<ElementType>>(values, n, lower, upper, yes, no, target); \
+} \
+template<typename ElementType> \
+DENSITAS_TARGET(isa) \
+void linspace(ElementType start, ElementType delta, std::size_t n, ElementType* target) \
+{ \
+    densitas::simd::kernels::linspace<ops<ElementType>>(start, delta, n, target); \
+} \
+template<typename ElementType> \
+DENSITAS_TARGET(isa) \
+void counts(const ElementType* weights, std::size_t n, ElementType divisor, std::size_t* counts) \
+{ \
+    densitas::simd::kernels::counts<ops<ElementType>>(weights, n, divisor, counts); \
+}
+
+
+namespace sse2 {
+
+template<typename ElementType>
+struct ops;
+
+template<>
+struct ops<double> {
+    typedef __m128d reg;
+    static const std::size_t width = 2;
+    DENSITAS_TARGET("sse2") static reg load(const double* data) { return _mm_loadu_pd(data); }
+    DENSITAS_TARGET("sse2") static void store(double* data, reg a) { _mm_storeu_pd(data, a); }
+    DENSITAS_TARGET("sse2") static reg set1(double value) { return _mm_set1_pd(value); }
+    DENSITAS_TARGET("sse2") static reg zero() { return _mm_setzero_pd(); }
+    DENSITAS_TARGET("sse2") static reg min(reg a, reg b) { return _mm_min_pd(a, b); }
+    DENSITAS_TARGET("sse2") static reg max(reg a, reg b) { return _mm_max_pd(a, b); }
+    DENSITAS_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    DENSITAS_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    DENSITAS_TARGET("sse2") static reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+    DENSITAS_TARGET("sse2") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const auto mask = _mm_or_pd(_mm_cmplt_pd(a, lower), _mm_cmpgt_pd(a, upper));
+        return _mm_or_pd(_mm_and_pd(mask, outside), _mm_andnot_pd(mask, inside));
+    }
+};
+
+template<>
+struct ops<float> {
+    typedef __m128 reg;
+    static const std::size_t width = 4;
+    DENSITAS_TARGET("sse2") static reg load(const float* data) { return _mm_loadu_ps(data); }
+    DENSITAS_TARGET("sse2") static void store(float* data, reg a) { _mm_storeu_ps(data, a); }
+    DENSITAS_TARGET("sse2") static reg set1(float value) { return _mm_set1_ps(value); }
+    DENSITAS_TARGET("sse2") static reg zero() { return _mm_setzero_ps(); }
+    DENSITAS_TARGET("sse2") static reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+    DENSITAS_TARGET("sse2") static reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+    DENSITAS_TARGET("sse2") static reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    DENSITAS_TARGET("sse2") static reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    DENSITAS_TARGET("sse2") static reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    DENSITAS_TARGET("sse2") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const auto mask = _mm_or_ps(_mm_cmplt_ps(a, lower), _mm_cmpgt_ps(a, upper));
+        return _mm_or_ps(_mm_and_ps(mask, outside), _mm_andnot_ps(mask, inside));
+    }
+};
+
+DENSITAS_DEFINE_ENTRY_POINTS("sse2")
+
+} // sse2
+
+
+namespace avx2 {
+
+template<typename ElementType>
+struct ops;
+
+template<>
+struct ops<double> {
+    typedef __m256d reg;
+    static const std::size_t width = 4;
+    DENSITAS_TARGET("avx2") static reg load(const double* data) { return _mm256_loadu_pd(data); }
+    DENSITAS_TARGET("avx2") static void store(double* data, reg a) { _mm256_storeu_pd(data, a); }
+    DENSITAS_TARGET("avx2") static reg set1(double value) { return _mm256_set1_pd(value); }
+    DENSITAS_TARGET("avx2") static reg zero() { return _mm256_setzero_pd(); }
+    DENSITAS_TARGET("avx2") static reg min(reg a, reg b) { return _mm256_min_pd(a, b); }
+    DENSITAS_TARGET("avx2") static reg max(reg a, reg b) { return _mm256_max_pd(a, b); }
+    DENSITAS_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    DENSITAS_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    DENSITAS_TARGET("avx2") static reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    DENSITAS_TARGET("avx2") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const auto mask = _mm256_or_pd(_mm256_cmp_pd(a, lower, _CMP_LT_OQ), _mm256_cmp_pd(a, upper, _CMP_GT_OQ));
+        return _mm256_blendv_pd(inside, outside, mask);
+    }
+};
+
+template<>
+struct ops<float> {
+    typedef __m256 reg;
+    static const std::size_t width = 8;
+    DENSITAS_TARGET("avx2") static reg load(const float* data) { return _mm256_loadu_ps(data); }
+    DENSITAS_TARGET("avx2") static void store(float* data, reg a) { _mm256_storeu_ps(data, a); }
+    DENSITAS_TARGET("avx2") static reg set1(float value) { return _mm256_set1_ps(value); }
+    DENSITAS_TARGET("avx2") static reg zero() { return _mm256_setzero_ps(); }
+    DENSITAS_TARGET("avx2") static reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+    DENSITAS_TARGET("avx2") static reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+    DENSITAS_TARGET("avx2") static reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    DENSITAS_TARGET("avx2") static reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    DENSITAS_TARGET("avx2") static reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    DENSITAS_TARGET("avx2") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const auto mask = _mm256_or_ps(_mm256_cmp_ps(a, lower, _CMP_LT_OQ), _mm256_cmp_ps(a, upper, _CMP_GT_OQ));
+        return _mm256_blendv_ps(inside, outside, mask);
+    }
+};
+
+DENSITAS_DEFINE_ENTRY_POINTS("avx2")
+
+} // avx2
+
+
+#ifdef DENSITAS_SIMD_AVX512
+
+// some versions of gcc warn about the deliberately undefined registers in
+// their own avx512 headers
+#if !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace avx512 {
+
+template<typename ElementType>
+struct ops;
+
+template<>
+struct ops<double> {
+    typedef __m512d reg;
+    static const std::size_t width = 8;
+    DENSITAS_TARGET("avx512f") static reg load(const double* data) { return _mm512_loadu_pd(data); }
+    DENSITAS_TARGET("avx512f") static void store(double* data, reg a) { _mm512_storeu_pd(data, a); }
+    DENSITAS_TARGET("avx512f") static reg set1(double value) { return _mm512_set1_pd(value); }
+    DENSITAS_TARGET("avx512f") static reg zero() { return _mm512_setzero_pd(); }
+    DENSITAS_TARGET("avx512f") static reg min(reg a, reg b) { return _mm512_min_pd(a, b); }
+    DENSITAS_TARGET("avx512f") static reg max(reg a, reg b) { return _mm512_max_pd(a, b); }
+    // avx512f implies fma so the rounding variants keep gcc from contracting a mul and an add
+    DENSITAS_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_round_pd(a, b, _MM_FROUND_CUR_DIRECTION); }
+    DENSITAS_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_round_pd(a, b, _MM_FROUND_CUR_DIRECTION); }
+    DENSITAS_TARGET("avx512f") static reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    DENSITAS_TARGET("avx512f") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const __mmask8 mask = _mm512_cmp_pd_mask(a, lower, _CMP_LT_OQ) | _mm512_cmp_pd_mask(a, upper, _CMP_GT_OQ);
+        return _mm512_mask_blend_pd(mask, inside, outside);
+    }
+};
+
+template<>
+struct ops<float> {
+    typedef __m512 reg;
+    static const std::size_t width = 16;
+    DENSITAS_TARGET("avx512f") static reg load(const float* data) { return _mm512_loadu_ps(data); }
+    DENSITAS_TARGET("avx512f") static void store(float* data, reg a) { _mm512_storeu_ps(data, a); }
+    DENSITAS_TARGET("avx512f") static reg set1(float value) { return _mm512_set1_ps(value); }
+    DENSITAS_TARGET("avx512f") static reg zero() { return _mm512_setzero_ps(); }
+    DENSITAS_TARGET("avx512f") static reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+    DENSITAS_TARGET("avx512f") static reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+    // avx512f implies fma so the rounding variants keep gcc from contracting a mul and an add
+    DENSITAS_TARGET("avx512f") static reg add(reg a, reg b) { return _mm512_add_round_ps(a, b, _MM_FROUND_CUR_DIRECTION); }
+    DENSITAS_TARGET("avx512f") static reg mul(reg a, reg b) { return _mm512_mul_round_ps(a, b, _MM_FROUND_CUR_DIRECTION); }
+    DENSITAS_TARGET("avx512f") static reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    DENSITAS_TARGET("avx512f") static reg select_outside(reg a, reg lower, reg upper, reg outside, reg inside)
+    {
+        const __mmask16 mask = _mm512_cmp_ps_mask(a, lower, _CMP_LT_OQ) | _mm512_cmp_ps_mask(a, upper, _CMP_GT_OQ);
+        return _mm512_mask_blend_ps(mask, inside, outside);
+    }
+};
+
+DENSITAS_DEFINE_ENTRY_POINTS("avx512f")
+
+} // avx512
+
+#if !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+#endif // DENSITAS_SIMD_AVX512
+
+#undef DENSITAS_DEFINE_ENTRY_POINTS
+
+#endif // DENSITAS_SIMD_X86
+
+
+#ifdef DENSITAS_SIMD_AVX512
+#define DENSITAS_DISPATCH_AVX512(call) \
+    case densitas::simd::instruction_set::avx512: return densitas::simd::avx512::call;
+#else
+#define DENSITAS_DISPATCH_AVX512(call)
+#endif
+
+#ifdef DENSITAS_SIMD_X86
+#define DENSITAS_DISPATCH(call) \
+    switch (densitas::simd::active_instruction_set()) { \
+    DENSITAS_DISPATCH_AVX512(call) \
+    case densitas::simd::instruction_set::avx2: return densitas::simd::avx2::call; \
+    case densitas::simd::instruction_set::sse2: return densitas::simd::sse2::call; \
+    default: return densitas::simd::scalar::call; \
+    }
+#else
+#define DENSITAS_DISPATCH(call) \
+    return densitas::simd::scalar::call;
+#endif
+
+
+} // anonymous
+
+
+densitas::simd::instruction_set supported_instruction_set()
+{
+    static const auto set = detect_instruction_set();
+    return set;
+}
+
+densitas::simd::instruction_set active_instruction_set()
+{
+    return active_set().load(std::memory_order_relaxed);
+}
+
+densitas::simd::instruction_set use_instruction_set(densitas::simd::instruction_set set)
+{
+    const auto supported = densitas::simd::supported_instruction_set();
+    if (set > supported)
+        set = supported;
+    active_set().store(set, std::memory_order_relaxed);
+    return set;
+}
+
+float minimum(const float* data, std::size_t n)
+{
+    DENSITAS_DISPATCH(minimum(data, n))
+}
+
+double minimum(const double* data, std::size_t n)
+{
+    DENSITAS_DISPATCH(minimum(data, n))
+}
+
+float positive_sum(const float* data, std::size_t n)
+{
+    DENSITAS_DISPATCH(positive_sum(data, n))
+}
+
+double positive_sum(const double* data, std::size_t n)
+{
+    DENSITAS_DISPATCH(positive_sum(data, n))
+}
+
+void classification_target(const float* values, std::size_t n, float lower, float upper, float yes, float no, float* target)
+{
+    DENSITAS_DISPATCH(classification_target(values, n, lower, upper, yes, no, target))
+}
+
+void classification_target(const double* values, std::size_t n, double lower, double upper, double yes, double no, double* target)
+{
+    DENSITAS_DISPATCH(classification_target(values, n, lower, upper, yes, no, target))
+}
+
+void linspace(float start, float delta, std::size_t n, float* target)
+{
+    DENSITAS_DISPATCH(linspace(start, delta, n, target))
+}
+
+void linspace(double start, double delta, std::size_t n, double* target)
+{
+    DENSITAS_DISPATCH(linspace(start, delta, n, target))
+}
+
+void counts(const float* weights, std::size_t n, float divisor, std::size_t* counts)
+{
+    DENSITAS_DISPATCH(counts(weights, n, divisor, counts))
+}
+
+void counts(const double* weights, std::size_t n, double divisor, std::size_t* counts)
+{
+    DENSITAS_DISPATCH(counts(weights, n, divisor, counts))
+}
+
+
+} // simd
+} // densitas
@@ -29,37 +29,157 @@ void condition_variable::wait()
 }
 
 
-task::task(std::shared_ptr<std::atomic_bool> done, std::thread&& thread)
-: done{done}, thread{std::move(thread)}
+thread_pool::thread_pool(std::size_t n_threads)
+: done_{false}, jobs_{}, threads_{}, mutex_{}, cond_var_{}
+{
+    reserve(n_threads);
+}
+
+thread_pool::~thread_pool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        done_ = true;
+    }
+    cond_var_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void thread_pool::push(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        jobs_.emplace_back(std::move(job));
+    }
+    cond_var_.notify_one();
+}
+
+void thread_pool::reserve(std::size_t n_threads)
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    while (threads_.size() < n_threads) {
+        threads_.emplace_back(&thread_pool::worker, this);
+    }
+}
+
+std::size_t thread_pool::n_threads() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return threads_.size();
+}
+
+void thread_pool::worker()
+{
+    for (;;) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock{mutex_};
+            cond_var_.wait(lock, [this]() { return this->done_ || !this->jobs_.empty(); });
+            if (jobs_.empty())
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        job();
+    }
+}
+
+
+densitas::core::thread_pool& default_thread_pool()
+{
+    static densitas::core::thread_pool pool;
+    return pool;
+}
+
+densitas::core::thread_pool& async_thread_pool()
+{
+    // constructed first so that it is destroyed after the jobs using it
+    densitas::core::default_thread_pool();
+    static densitas::core::thread_pool pool{std::max(1u, std::thread::hardware_concurrency())};
+    return pool;
+}
+
+
+task::task(std::shared_ptr<std::atomic_bool> done)
+: done{done}
 {}
 
 
 task_manager::task_manager(int max_tasks)
-: max_tasks_{static_cast<std::size_t>(max_tasks<1 ? 1 : max_tasks)}, tasks_{}, cond_var_{}
-{}
+: max_tasks_{static_cast<std::size_t>(max_tasks<1 ? 1 : max_tasks)}, tasks_{},
+  cond_var_{std::make_shared<densitas::core::condition_variable>()}, pool_(densitas::core::default_thread_pool())
+{
+    pool_.reserve(max_tasks_);
+}
+
+task_manager::task_manager(int max_tasks, densitas::core::thread_pool& pool)
+: max_tasks_{static_cast<std::size_t>(max_tasks<1 ? 1 : max_tasks)}, tasks_{},
+  cond_var_{std::make_shared<densitas::core::condition_variable>()}, pool_(pool)
+{
+    pool_.reserve(max_tasks_);
+}
 
 task_manager::~task_manager()
 {
-    for (auto& task : tasks_) {
-        task.thread.join();
+    remove_finished();
+    while (!tasks_.empty()) {
+        cond_var_->wait();
+        remove_finished();
     }
 }
 
 void task_manager::wait_for_slot()
 {
     while (tasks_.size() >= max_tasks_) {
-        cond_var_.wait();
-        for (auto it=tasks_.begin(); it!=tasks_.cend();) {
-            if (it->done->load()) {
-                it->thread.join();
-                tasks_.erase(it++);
-            } else {
-                ++it;
-            }
+        cond_var_->wait();
+        remove_finished();
+    }
+}
+
+void task_manager::remove_finished()
+{
+    for (auto it=tasks_.begin(); it!=tasks_.cend();) {
+        if (it->done->load()) {
+            tasks_.erase(it++);
+        } else {
+            ++it;
         }
     }
 }
 
 
+range_dispenser::range_dispenser(std::size_t n_items, std::size_t n_workers, std::size_t min_chunk)
+: n_items_{n_items}, n_workers_{n_workers<1 ? 1 : n_workers}, min_chunk_{min_chunk<1 ? 1 : min_chunk}, position_{0}
+{}
+
+range_dispenser::~range_dispenser()
+{}
+
+bool range_dispenser::next(densitas::core::index_range& range)
+{
+    auto begin = position_.load();
+    std::size_t end = 0;
+    do {
+        if (begin >= n_items_)
+            return false;
+        const auto remaining = n_items_ - begin;
+        auto chunk = remaining / (2 * n_workers_);
+        if (chunk < min_chunk_) chunk = min_chunk_;
+        if (chunk > remaining) chunk = remaining;
+        end = begin + chunk;
+    } while (!position_.compare_exchange_weak(begin, end));
+    range.begin = begin;
+    range.end = end;
+    return true;
+}
+
+void range_dispenser::stop()
+{
+    position_ = n_items_;
+}
+
+
 } // core
 } // densitas
@@ -0,0 +1,138 @@
+#include "densitas/tracer.hpp"
+#include "densitas/densitas_error.hpp"
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+
+namespace densitas {
+
+
+namespace {
+
+void write_string(std::ostream& stream, const std::string& value)
+{
+    stream << '"';
+    for (const char c : value) {
+        switch (c) {
+        case '"': stream << "\\\""; break;
+        case '\\': stream << "\\\\"; break;
+        case '\n': stream << "\\n"; break;
+        case '\t': stream << "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+                stream << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            else
+                stream << c;
+        }
+    }
+    stream << '"';
+}
+
+} // anonymous
+
+
+tracer::tracer()
+: start_{std::chrono::steady_clock::now()}, mutex_{}, events_{}, threads_{}
+{}
+
+tracer::~tracer()
+{}
+
+double tracer::now() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start_).count();
+}
+
+void tracer::record(const std::string& name, const std::string& category, double begin, double end, const densitas::tracer::arguments& args)
+{
+    const auto id = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock{mutex_};
+    const auto thread = threads_.insert(std::make_pair(id, threads_.size())).first->second;
+    events_.push_back(event{name, category, begin, end - begin, thread, args});
+}
+
+std::size_t tracer::n_events() const
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    return events_.size();
+}
+
+void tracer::clear()
+{
+    std::lock_guard<std::mutex> lock{mutex_};
+    events_.clear();
+}
+
+void tracer::write(std::ostream& stream) const
+{
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(3);
+    json << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    {
+        std::lock_guard<std::mutex> lock{mutex_};
+        bool first = true;
+        for (const auto& thread : threads_) {
+            json << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread.second
+                 << ",\"args\":{\"name\":\"thread " << thread.second << "\"}}";
+            first = false;
+        }
+        for (const auto& event : events_) {
+            json << (first ? "" : ",") << "\n{\"name\":";
+            write_string(json, event.name);
+            json << ",\"cat\":";
+            write_string(json, event.category);
+            json << ",\"ph\":\"X\",\"ts\":" << event.begin << ",\"dur\":" << event.duration
+                 << ",\"pid\":1,\"tid\":" << event.thread << ",\"args\":{";
+            for (std::size_t i=0; i<event.args.size(); ++i) {
+                json << (i ? "," : "");
+                write_string(json, event.args[i].first);
+                json << ":" << event.args[i].second;
+            }
+            json << "}}";
+            first = false;
+        }
+    }
+    json << "\n]}\n";
+    stream << json.str();
+}
+
+void tracer::save(const std::string& filename) const
+{
+    std::ofstream stream(filename);
+    if (!stream)
+        throw densitas::densitas_error("cannot open file for writing: " + filename);
+    write(stream);
+    if (!stream)
+        throw densitas::densitas_error("failed writing to file: " + filename);
+}
+
+
+namespace core {
+
+
+trace_scope::trace_scope(densitas::tracer* tracer, const char* name, const char* category, std::initializer_list<std::pair<const char*, std::size_t>> args)
+: tracer_{tracer}, name_{name}, category_{category}, args_{}, begin_{0}
+{
+    if (tracer_) {
+        for (const auto& arg : args) {
+            args_.emplace_back(arg.first, arg.second);
+        }
+        begin_ = tracer_->now();
+    }
+}
+
+trace_scope::~trace_scope()
+{
+    if (!tracer_)
+        return;
+    try {
+        tracer_->record(name_, category_, begin_, tracer_->now(), args_);
+    } catch (...) {
+        // never throw from a destructor, the event is lost
+    }
+}
+
+
+} // core
+} // densitas
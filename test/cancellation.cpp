@@ -0,0 +1,32 @@
+#include "utils.hpp"
+
+
+COLLECTION(cancellation) {
+
+TEST(test_cancel) {
+    densitas::cancellation_token token;
+    assert_false(token.is_cancelled(), SPOT);
+    token.cancel();
+    assert_true(token.is_cancelled(), SPOT);
+}
+
+TEST(test_deadline_passed) {
+    densitas::cancellation_token token(std::chrono::steady_clock::now());
+    assert_true(token.is_cancelled(), SPOT);
+}
+
+TEST(test_deadline_ahead) {
+    densitas::cancellation_token token(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    assert_false(token.is_cancelled(), SPOT);
+    token.cancel();
+    assert_true(token.is_cancelled(), SPOT);
+}
+
+TEST(test_cancel_from_other_thread) {
+    densitas::cancellation_token token;
+    std::thread thread([&token]() { token.cancel(); });
+    thread.join();
+    assert_true(token.is_cancelled(), SPOT);
+}
+
+}
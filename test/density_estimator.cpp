@@ -1,6 +1,49 @@
 #include "utils.hpp"
 
 
+// a model whose training is done by a specialized adapter
+struct adapted_model {
+
+    bool trained_by_adapter;
+
+    adapted_model()
+        : trained_by_adapter(false)
+    {}
+
+    std::unique_ptr<adapted_model> clone() const
+    {
+        return std::unique_ptr<adapted_model>(new adapted_model(*this));
+    }
+
+    void train(const matrix_t&, vector_t&)
+    {
+        trained_by_adapter = false;
+    }
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        vector_t probas(X.n_rows);
+        std::fill(probas.begin(), probas.end(), 0.5);
+        return probas;
+    }
+
+};
+
+
+namespace densitas {
+namespace model_adapter {
+
+template<>
+inline
+void train<adapted_model, const matrix_t, vector_t>(adapted_model& model, const matrix_t&, vector_t&)
+{
+    model.trained_by_adapter = true;
+}
+
+} // model_adapter
+} // densitas
+
+
 COLLECTION(density_estimator) {
 
 
@@ -34,6 +77,11 @@ struct estimator_t : densitas::density_estimator<estimator_t, mock_model, matrix
         return accuracy_predicted_quantiles_;
     }
 
+    bool get_exact_predicted_quantiles() const
+    {
+        return exact_predicted_quantiles_;
+    }
+
 };
 
 matrix_t get_X()
@@ -84,10 +132,11 @@ TEST(test_train_async) {
     make_test_train(true);
 }
 
-void make_test_predict(bool async)
+void make_test_predict(bool async, bool exact=true)
 {
     auto estimator = train_estimator();
     estimator->predicted_quantiles(mkcol({0.5, 0.9}));
+    estimator->exact_predicted_quantiles(exact);
     const auto X = get_X();
     const auto threads = async ? 3 : 1;
     const auto y_resp = estimator->predict(X, threads);
@@ -108,6 +157,1092 @@ TEST(test_predict_async) {
     make_test_predict(true);
 }
 
+TEST(test_predict_with_replication) {
+    make_test_predict(false, false);
+}
+
+struct batch_model {
+
+    double prediction;
+
+    batch_model()
+    : prediction{0.5}
+    {}
+
+    std::unique_ptr<batch_model> clone() const
+    {
+        return std::unique_ptr<batch_model>{new batch_model(*this)};
+    }
+
+    void train(matrix_t&, vector_t&)
+    {}
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        vector_t probas(X.n_rows);
+        std::fill(probas.begin(), probas.end(), prediction);
+        return probas;
+    }
+
+};
+
+struct batch_estimator_t : densitas::density_estimator<batch_estimator_t, batch_model, matrix_t, vector_t> {
+
+    batch_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    batch_estimator_t(const batch_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+};
+
+void make_test_predict_batched(std::size_t batch_size, bool async)
+{
+    batch_estimator_t estimator(batch_model(), 2);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}));
+    estimator.predicted_quantiles(mkcol({0.5, 0.9}));
+    estimator.predict_batch_size(batch_size);
+    const auto threads = async ? 3 : 1;
+    const auto y_resp = estimator.predict(X, threads);
+    auto y_exp = matrix_t(X.n_rows, 2u);
+    for (std::size_t i=0; i<X.n_rows; ++i) {
+        y_exp.row(i) = mkrow({5.5, 7.5});
+    }
+    assert_equal_containers(y_exp, y_resp, SPOT);
+}
+
+TEST(test_predict_batched) {
+    make_test_predict_batched(2, false);
+    make_test_predict_batched(5, false);
+    make_test_predict_batched(100, false);
+}
+
+TEST(test_predict_batched_async) {
+    make_test_predict_batched(2, true);
+    make_test_predict_batched(5, true);
+}
+
+TEST(test_predict_batched_with_wrong_number_of_probas) {
+    auto estimator = train_estimator();
+    estimator->predict_batch_size(5);
+    const auto X = get_X();
+    assert_throw<densitas::densitas_error>([&]() { estimator->predict(X); }, SPOT);
+}
+
+TEST(test_predict_batch_size_zero) {
+    auto model = mock_model();
+    estimator_t estimator(model, 2);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_batch_size(0); }, SPOT);
+}
+
+void make_test_metrics(int threads, std::size_t batch_size)
+{
+    typedef densitas::metrics::phase phase;
+    auto metrics = std::make_shared<densitas::metrics>();
+    batch_estimator_t estimator(batch_model(), 2);
+    estimator.metrics(metrics);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}), threads);
+    assert_equal(1u, metrics->get(phase::bin_edges).count, SPOT);
+    assert_equal(1u, metrics->get(phase::centers).count, SPOT);
+    for (auto p : {phase::classification_targets, phase::model_training}) {
+        assert_equal(2u, metrics->get(p).count, SPOT);
+        assert_equal(2u, metrics->n_models(p), SPOT);
+        assert_equal(1u, metrics->get(p, 1).count, SPOT);
+    }
+    assert_equal(0u, metrics->get(phase::model_scoring).count, SPOT);
+    metrics->reset();
+    estimator.predict_batch_size(batch_size);
+    estimator.predict(X, threads);
+    const auto n_calls = (X.n_rows + batch_size - 1) / batch_size;
+    assert_equal(2 * n_calls, metrics->get(phase::model_scoring).count, SPOT);
+    assert_equal(n_calls, metrics->get(phase::model_scoring, 0).count, SPOT);
+    assert_equal(X.n_rows, metrics->get(phase::quantile_extraction).count, SPOT);
+    assert_equal(0u, metrics->get(phase::model_training).count, SPOT);
+    const auto cloned = estimator.clone();
+    cloned->predict(X);
+    assert_equal(2 * X.n_rows, metrics->get(phase::quantile_extraction).count, SPOT);
+    estimator.metrics(nullptr);
+    estimator.predict(X);
+    assert_equal(2 * X.n_rows, metrics->get(phase::quantile_extraction).count, SPOT);
+}
+
+TEST(test_metrics) {
+    make_test_metrics(1, 1);
+    make_test_metrics(1, 2);
+}
+
+TEST(test_metrics_async) {
+    make_test_metrics(3, 1);
+    make_test_metrics(3, 2);
+}
+
+std::size_t count_events(const std::string& json, const std::string& name)
+{
+    const auto pattern = "\"name\":\"" + name + "\"";
+    std::size_t count = 0;
+    for (auto pos = json.find(pattern); pos != std::string::npos; pos = json.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+void make_test_tracer(int threads)
+{
+    auto tracer = std::make_shared<densitas::tracer>();
+    batch_estimator_t estimator(batch_model(), 3);
+    estimator.tracer(tracer);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}), threads);
+    estimator.predict(X, threads);
+    std::ostringstream stream;
+    tracer->write(stream);
+    const auto json = stream.str();
+    assert_equal(1u, count_events(json, "train"), SPOT);
+    assert_equal(3u, count_events(json, "train_model"), SPOT);
+    assert_equal(threads > 1 ? 3u : 0u, count_events(json, "wait_for_slot"), SPOT);
+    assert_equal(1u, count_events(json, "predict"), SPOT);
+    assert_true(count_events(json, "predict_range") >= 1u, SPOT);
+    assert_true(json.find("\"args\":{\"model\":2}") != std::string::npos, SPOT);
+    estimator.tracer(nullptr);
+    const auto n_events = tracer->n_events();
+    estimator.predict(X, threads);
+    assert_equal(n_events, tracer->n_events(), SPOT);
+}
+
+TEST(test_tracer) {
+    make_test_tracer(1);
+}
+
+TEST(test_tracer_async) {
+    make_test_tracer(3);
+}
+
+struct shared_features_model {
+
+    const matrix_t* train_X;
+
+    shared_features_model()
+    : train_X{nullptr}
+    {}
+
+    std::unique_ptr<shared_features_model> clone() const
+    {
+        return std::unique_ptr<shared_features_model>{new shared_features_model(*this)};
+    }
+
+    void train(const matrix_t& X, vector_t&)
+    {
+        train_X = &X;
+    }
+
+    vector_t predict_proba(matrix_t&) const
+    {
+        return mkcol({0.5});
+    }
+
+};
+
+struct shared_features_estimator_t : densitas::density_estimator<shared_features_estimator_t, shared_features_model, matrix_t, vector_t> {
+
+    shared_features_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    shared_features_estimator_t(const shared_features_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+    const std::vector<std::unique_ptr<shared_features_model>>& get_models() const
+    {
+        return models_;
+    }
+
+};
+
+void make_test_train_shares_features(bool async)
+{
+    shared_features_estimator_t estimator(shared_features_model(), 3);
+    const auto X = get_X();
+    const auto threads = async ? 3 : 1;
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}), threads);
+    for (const auto& model : estimator.get_models()) {
+        assert_equal(&X, model->train_X, SPOT);
+    }
+}
+
+TEST(test_train_shares_features) {
+    make_test_train_shares_features(false);
+}
+
+TEST(test_train_shares_features_async) {
+    make_test_train_shares_features(true);
+}
+
+struct serializable_estimator_t : densitas::density_estimator<serializable_estimator_t, serializable_model, matrix_t, vector_t> {
+
+    serializable_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    serializable_estimator_t(const serializable_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+    const std::vector<std::unique_ptr<serializable_model>>& get_models() const
+    {
+        return models_;
+    }
+
+    vector_t get_trained_centers() const
+    {
+        return trained_centers_;
+    }
+
+};
+
+const std::string estimator_file = "densitas_test_estimator.bin";
+
+TEST(test_save_and_load) {
+    serializable_estimator_t estimator(serializable_model(), 3);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}));
+    estimator.predicted_quantiles(mkcol({0.1, 0.5, 0.9, 0.99}));
+    estimator.accuracy_predicted_quantiles(1e-3);
+    estimator.exact_predicted_quantiles(false);
+    estimator.predict_batch_size(2);
+    estimator.save(estimator_file);
+    serializable_estimator_t loaded;
+    loaded.load(estimator_file);
+    std::remove(estimator_file.c_str());
+    assert_equal_containers(estimator.get_trained_centers(), loaded.get_trained_centers(), SPOT);
+    assert_equal(3u, loaded.get_models().size(), SPOT);
+    for (std::size_t i=0; i<3; ++i) {
+        assert_equal(estimator.get_models()[i]->prediction, loaded.get_models()[i]->prediction, SPOT);
+    }
+    assert_equal_containers(estimator.predict(X), loaded.predict(X), SPOT);
+    const auto cloned = loaded.clone();
+    assert_equal_containers(estimator.predict(X), cloned->predict(X), SPOT);
+}
+
+TEST(test_save_untrained) {
+    serializable_estimator_t estimator(serializable_model(), 3);
+    std::ostringstream stream;
+    assert_throw<densitas::densitas_error>([&]() { estimator.save(stream); }, SPOT);
+}
+
+TEST(test_load_nonexistent_file) {
+    serializable_estimator_t estimator;
+    assert_throw<densitas::densitas_error>([&]() { estimator.load("densitas_no_such_file.bin"); }, SPOT);
+}
+
+TEST(test_load_corrupted_file) {
+    serializable_estimator_t estimator(serializable_model(), 2);
+    estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}));
+    std::ostringstream stream;
+    estimator.save(stream);
+    const auto data = stream.str();
+    auto write_file = [](const std::string& contents) {
+        std::ofstream file(estimator_file, std::ios::binary);
+        file.write(contents.data(), contents.size());
+    };
+    serializable_estimator_t loaded;
+    write_file(data.substr(0, data.size() - 1));
+    assert_throw<densitas::densitas_error>([&]() { loaded.load(estimator_file); }, SPOT);
+    write_file("X" + data.substr(1));
+    assert_throw<densitas::densitas_error>([&]() { loaded.load(estimator_file); }, SPOT);
+    write_file(data);
+    loaded.load(estimator_file);
+    std::remove(estimator_file.c_str());
+    assert_equal_containers(estimator.predict(get_X()), loaded.predict(get_X()), SPOT);
+}
+
+struct incremental_estimator_t : densitas::density_estimator<incremental_estimator_t, incremental_model, matrix_t, vector_t> {
+
+    incremental_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    incremental_estimator_t(const incremental_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+    const std::vector<std::unique_ptr<incremental_model>>& get_models() const
+    {
+        return models_;
+    }
+
+    vector_t get_trained_centers() const
+    {
+        return trained_centers_;
+    }
+
+};
+
+void make_test_partial_train(int threads)
+{
+    incremental_estimator_t estimator(incremental_model(), 3);
+    const auto X = get_X();
+    const auto y = mkcol({5, 6, 7, 8, 9});
+    estimator.train(X, y, threads);
+    const auto more_y = mkcol({4, 6.5, 7.5, 7.5, 12});
+    estimator.partial_train(X, more_y, threads);
+    // the same as training on all events with the bin edges of the first ones
+    const auto edges = densitas::math::quantiles<double>(y, densitas::math::linspace<vector_t>(0., 1., 4));
+    const auto all_y = mkcol({5, 6, 7, 8, 9, 4, 6.5, 7.5, 7.5, 12});
+    const auto bins = densitas::math::bin_ranges<double>(all_y, edges);
+    const auto centers = densitas::math::centers_from_bins<double>(all_y, bins, 3);
+    assert_equal_containers(centers, estimator.get_trained_centers(), SPOT);
+    const auto& models = estimator.get_models();
+    for (std::size_t i=0; i<3; ++i) {
+        const auto target = densitas::math::make_classification_target_from_bins<incremental_model, double, vector_t>(bins, i);
+        assert_equal(static_cast<std::size_t>(std::count(target.begin(), target.end(), dyes)), models[i]->n_yes, SPOT);
+        assert_equal(10u, models[i]->n_events, SPOT);
+    }
+}
+
+TEST(test_partial_train) {
+    make_test_partial_train(1);
+}
+
+TEST(test_partial_train_async) {
+    make_test_partial_train(3);
+}
+
+TEST(test_partial_train_untrained) {
+    incremental_estimator_t estimator(incremental_model(), 3);
+    assert_throw<densitas::densitas_error>([&]() { estimator.partial_train(get_X(), mkcol({5, 6, 7, 8, 9})); }, SPOT);
+}
+
+TEST(test_partial_train_without_events) {
+    incremental_estimator_t estimator(incremental_model(), 3);
+    estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}));
+    assert_throw<densitas::densitas_error>([&]() { estimator.partial_train(matrix_t(0, 3), mkcol({})); }, SPOT);
+}
+
+TEST(test_partial_train_not_supported) {
+    serializable_estimator_t estimator(serializable_model(), 3);
+    estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}));
+    assert_throw<densitas::densitas_error>([&]() { estimator.partial_train(get_X(), mkcol({5, 6, 7, 8, 9})); }, SPOT);
+}
+
+TEST(test_partial_train_not_supported_async) {
+    serializable_estimator_t estimator(serializable_model(), 3);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}));
+    const auto expected = estimator.predict(X);
+    assert_throw<densitas::densitas_error>([&]() { estimator.partial_train(X, mkcol({5, 6, 7, 8, 9}), 2); }, SPOT);
+    assert_equal_containers(expected, estimator.predict(X), SPOT);
+}
+
+// a model whose partial_train modifies the features while train does not
+struct mutating_incremental_model {
+
+    std::size_t n_partial_trains;
+
+    mutating_incremental_model()
+        : n_partial_trains(0)
+    {}
+
+    std::unique_ptr<mutating_incremental_model> clone() const
+    {
+        return std::unique_ptr<mutating_incremental_model>(new mutating_incremental_model(*this));
+    }
+
+    void train(const matrix_t&, vector_t&)
+    {
+        n_partial_trains = 0;
+    }
+
+    void partial_train(matrix_t& X, vector_t&)
+    {
+        X(0, 0) = -1;
+        ++n_partial_trains;
+    }
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        vector_t probas(X.n_rows);
+        std::fill(probas.begin(), probas.end(), 0.5);
+        return probas;
+    }
+
+};
+
+struct mutating_incremental_estimator_t : densitas::density_estimator<mutating_incremental_estimator_t, mutating_incremental_model, matrix_t, vector_t> {
+
+    mutating_incremental_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    mutating_incremental_estimator_t(const mutating_incremental_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+    const std::vector<std::unique_ptr<mutating_incremental_model>>& get_models() const
+    {
+        return models_;
+    }
+
+};
+
+void make_test_partial_train_mutating_features(int threads)
+{
+    static_assert(!densitas::model_adapter::mutates_features<mutating_incremental_model, matrix_t, vector_t>::value, "");
+    static_assert(densitas::model_adapter::partial_mutates_features<mutating_incremental_model, matrix_t, vector_t>::value, "");
+    mutating_incremental_estimator_t estimator(mutating_incremental_model(), 3);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}), threads);
+    estimator.partial_train(X, mkcol({4, 6.5, 7.5, 7.5, 12}), threads);
+    assert_equal_containers(get_X(), X, SPOT);
+    for (const auto& model : estimator.get_models()) {
+        assert_equal(1u, model->n_partial_trains, SPOT);
+    }
+}
+
+TEST(test_partial_train_mutating_features) {
+    make_test_partial_train_mutating_features(1);
+}
+
+TEST(test_partial_train_mutating_features_async) {
+    make_test_partial_train_mutating_features(3);
+}
+
+// a model that fails training
+struct failing_model {
+
+    std::unique_ptr<failing_model> clone() const
+    {
+        return std::unique_ptr<failing_model>(new failing_model(*this));
+    }
+
+    void train(const matrix_t&, vector_t&)
+    {
+        throw densitas::densitas_error("training failed");
+    }
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        return vector_t(X.n_rows);
+    }
+
+};
+
+struct failing_estimator_t : densitas::density_estimator<failing_estimator_t, failing_model, matrix_t, vector_t> {
+
+    failing_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    failing_estimator_t(const failing_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+};
+
+struct adapted_estimator_t : densitas::density_estimator<adapted_estimator_t, adapted_model, matrix_t, vector_t> {
+
+    adapted_estimator_t()
+    : density_estimator_type{}
+    {}
+
+    adapted_estimator_t(const adapted_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}
+    {}
+
+    const std::vector<std::unique_ptr<adapted_model>>& get_models() const
+    {
+        return models_;
+    }
+
+};
+
+TEST(test_train_with_specialized_adapter) {
+    adapted_estimator_t estimator(adapted_model(), 3);
+    estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}), 2);
+    for (const auto& model : estimator.get_models()) {
+        assert_true(model->trained_by_adapter, SPOT);
+    }
+}
+
+TEST(test_train_with_failing_model) {
+    failing_estimator_t estimator(failing_model(), 4);
+    assert_throw<densitas::densitas_error>([&]() { estimator.train(get_X(), mkcol({5, 6, 7, 8, 9})); }, SPOT);
+}
+
+TEST(test_train_with_failing_model_async) {
+    failing_estimator_t estimator(failing_model(), 4);
+    assert_throw<densitas::densitas_error>([&]() { estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}), 2); }, SPOT);
+    densitas::cancellation_token token;
+    assert_throw<densitas::densitas_error>([&]() { estimator.train(get_X(), mkcol({5, 6, 7, 8, 9}), token, 3); }, SPOT);
+}
+
+TEST(test_partial_train_after_save_and_load) {
+    incremental_estimator_t estimator(incremental_model(), 3);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}));
+    estimator.save(estimator_file);
+    incremental_estimator_t loaded;
+    loaded.load(estimator_file);
+    std::remove(estimator_file.c_str());
+    const auto more_y = mkcol({4, 6.5, 7.5, 7.5, 12});
+    estimator.partial_train(X, more_y);
+    loaded.partial_train(X, more_y);
+    assert_equal_containers(estimator.get_trained_centers(), loaded.get_trained_centers(), SPOT);
+    assert_equal_containers(estimator.predict(X), loaded.predict(X), SPOT);
+    const auto cloned = loaded.clone();
+    cloned->partial_train(X, more_y);
+    estimator.partial_train(X, more_y);
+    assert_equal_containers(estimator.predict(X), cloned->predict(X), SPOT);
+}
+
+void make_test_predict_stream(int threads)
+{
+    serializable_estimator_t estimator(serializable_model(), 3);
+    const auto X = get_X();
+    estimator.train(X, mkcol({5, 6, 7, 8, 9}));
+    const std::size_t block_size = 2;
+    std::size_t position = 0;
+    std::size_t in_flight = 0;
+    std::size_t max_in_flight = 0;
+    auto source = [&](matrix_t& block) {
+        if (position >= X.n_rows)
+            return false;
+        const auto n_rows = std::min<std::size_t>(block_size, X.n_rows - position);
+        block = densitas::core::extract_rows<double>(X, position, n_rows);
+        position += n_rows;
+        max_in_flight = std::max(max_in_flight, ++in_flight);
+        return true;
+    };
+    std::vector<std::size_t> indices;
+    std::vector<matrix_t> blocks;
+    auto sink = [&](std::size_t block_index, const matrix_t& block) {
+        indices.push_back(block_index);
+        blocks.push_back(block);
+        --in_flight;
+    };
+    estimator.predict_stream(source, sink, threads);
+    assert_equal_containers(std::vector<std::size_t>({0, 1, 2}), indices, SPOT);
+    const auto prediction = estimator.predict(X);
+    for (std::size_t i=0; i<blocks.size(); ++i) {
+        const auto expected = densitas::core::extract_rows<double>(prediction, i * block_size, blocks[i].n_rows);
+        assert_equal_containers(expected, blocks[i], SPOT);
+    }
+    assert_true(max_in_flight <= static_cast<std::size_t>(std::max(threads, 1)), SPOT);
+}
+
+TEST(test_predict_stream) {
+    make_test_predict_stream(1);
+}
+
+TEST(test_predict_stream_async) {
+    make_test_predict_stream(2);
+    make_test_predict_stream(4);
+}
+
+TEST(test_predict_stream_without_events) {
+    auto estimator = train_estimator();
+    std::size_t n_sinks = 0;
+    estimator->predict_stream([](matrix_t&) { return false; }, [&](std::size_t, const matrix_t&) { ++n_sinks; }, 3);
+    assert_equal(0u, n_sinks, SPOT);
+}
+
+void make_test_predict_stream_with_error(int threads, bool in_source)
+{
+    auto estimator = train_estimator();
+    const auto X = get_X();
+    std::size_t n_blocks = 0;
+    auto source = [&](matrix_t& block) {
+        if (in_source && n_blocks == 3)
+            throw densitas::densitas_error("source failed");
+        block = densitas::core::extract_rows<double>(X, 0, 1);
+        return n_blocks++ < 10;
+    };
+    auto sink = [&](std::size_t block_index, const matrix_t&) {
+        if (!in_source && block_index == 3)
+            throw densitas::densitas_error("sink failed");
+    };
+    assert_throw<densitas::densitas_error>([&]() { estimator->predict_stream(source, sink, threads); }, SPOT);
+}
+
+TEST(test_predict_stream_with_error) {
+    make_test_predict_stream_with_error(1, true);
+    make_test_predict_stream_with_error(1, false);
+    make_test_predict_stream_with_error(3, true);
+    make_test_predict_stream_with_error(3, false);
+}
+
+struct cancelling_estimator_t : densitas::density_estimator<cancelling_estimator_t, mock_model, matrix_t, vector_t> {
+
+    cancelling_estimator_t()
+    : density_estimator_type{}, token{nullptr}, cancel_at{0}, n_calls{0}
+    {
+        predict_status_ = true;
+    }
+
+    cancelling_estimator_t(const mock_model& model, std::size_t n_models)
+    : density_estimator_type{model, n_models}, token{nullptr}, cancel_at{0}, n_calls{0}
+    {
+        predict_status_ = true;
+    }
+
+    cancelling_estimator_t(const cancelling_estimator_t&) = delete;
+    cancelling_estimator_t& operator=(const cancelling_estimator_t&) = delete;
+
+    virtual void on_train_status(const mock_model&, std::size_t, const matrix_t&, const train_params&) const
+    {
+        count();
+    }
+
+    virtual void on_predict_status(const matrix_t&, const std::vector<std::unique_ptr<mock_model>>&, std::size_t, const predict_params&) const
+    {
+        count();
+    }
+
+    void count() const
+    {
+        if (token && ++n_calls == cancel_at)
+            token->cancel();
+    }
+
+    vector_t get_trained_centers() const
+    {
+        return trained_centers_;
+    }
+
+    densitas::cancellation_token* token;
+    std::size_t cancel_at;
+    mutable std::atomic<std::size_t> n_calls;
+};
+
+std::unique_ptr<cancelling_estimator_t> make_cancelling_estimator(std::size_t n_models)
+{
+    auto model = mock_model();
+    model.prediction = mkcol({0.5});
+    return std::unique_ptr<cancelling_estimator_t>(new cancelling_estimator_t(model, n_models));
+}
+
+struct status_estimator_t : densitas::density_estimator<status_estimator_t, nearest_mean_model<vector_t, matrix_t, double>, matrix_t, vector_t> {
+
+    explicit
+    status_estimator_t(bool enabled=true)
+    : density_estimator_type{}, events{}
+    {
+        predict_status_ = enabled;
+    }
+
+    virtual void on_predict_status(const matrix_t&, const std::vector<std::unique_ptr<nearest_mean_model<vector_t, matrix_t, double>>>&, std::size_t event_index, const predict_params&) const
+    {
+        // not synchronized, the calls must be serialized
+        events.push_back(event_index);
+    }
+
+    mutable std::vector<std::size_t> events;
+};
+
+void make_test_predict_status_serialized(int threads, std::size_t batch_size)
+{
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    status_estimator_t estimator;
+    estimator.set_models(nearest_mean_model<vector_t, matrix_t, double>(), 3);
+    estimator.predict_batch_size(batch_size);
+    estimator.train(X, y);
+    estimator.predict(X, threads);
+    std::vector<std::size_t> expected(X.n_rows);
+    std::iota(expected.begin(), expected.end(), std::size_t{0});
+    assert_equal_containers(expected, estimator.events, SPOT);
+}
+
+TEST(test_predict_status_serialized) {
+    make_test_predict_status_serialized(1, 1);
+    make_test_predict_status_serialized(4, 1);
+    make_test_predict_status_serialized(4, 7);
+}
+
+TEST(test_predict_status_not_enabled) {
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    status_estimator_t estimator{false};
+    estimator.set_models(nearest_mean_model<vector_t, matrix_t, double>(), 3);
+    estimator.train(X, y);
+    estimator.predict(X, 4);
+    assert_true(estimator.events.empty(), SPOT);
+}
+
+void make_test_predict_cancelled(int threads)
+{
+    auto estimator = make_cancelling_estimator(2);
+    const auto X = get_X();
+    estimator->train(X, mkcol({5, 6, 7, 8, 9}));
+    densitas::cancellation_token token;
+    token.cancel();
+    std::vector<bool> completed;
+    estimator->predict(X, token, completed, threads);
+    assert_equal_containers(std::vector<bool>(5, false), completed, SPOT);
+}
+
+TEST(test_predict_cancelled) {
+    make_test_predict_cancelled(1);
+}
+
+TEST(test_predict_cancelled_async) {
+    make_test_predict_cancelled(3);
+}
+
+TEST(test_predict_cancelled_in_progress) {
+    auto estimator = make_cancelling_estimator(2);
+    const auto X = get_X();
+    estimator->train(X, mkcol({5, 6, 7, 8, 9}));
+    const auto expected = estimator->predict(X);
+    densitas::cancellation_token token;
+    estimator->token = &token;
+    estimator->cancel_at = 2;
+    std::vector<bool> completed;
+    const auto prediction = estimator->predict(X, token, completed);
+    assert_equal_containers(std::vector<bool>({true, true, false, false, false}), completed, SPOT);
+    for (std::size_t i=0; i<2; ++i) {
+        assert_equal_containers(densitas::core::extract_row<double, vector_t>(expected, i), densitas::core::extract_row<double, vector_t>(prediction, i), SPOT);
+    }
+}
+
+void make_test_predict_deadline_ahead(int threads)
+{
+    auto estimator = make_cancelling_estimator(2);
+    const auto X = get_X();
+    estimator->train(X, mkcol({5, 6, 7, 8, 9}));
+    densitas::cancellation_token token(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    std::vector<bool> completed;
+    const auto prediction = estimator->predict(X, token, completed, threads);
+    assert_equal_containers(std::vector<bool>(5, true), completed, SPOT);
+    assert_equal_containers(estimator->predict(X), prediction, SPOT);
+}
+
+TEST(test_predict_deadline_ahead) {
+    make_test_predict_deadline_ahead(1);
+}
+
+TEST(test_predict_deadline_ahead_async) {
+    make_test_predict_deadline_ahead(3);
+}
+
+void make_test_train_cancelled(int threads)
+{
+    auto estimator = make_cancelling_estimator(3);
+    const auto X = get_X();
+    densitas::cancellation_token token(std::chrono::steady_clock::now());
+    assert_false(estimator->train(X, mkcol({5, 6, 7, 8, 9}), token, threads), SPOT);
+    assert_equal(0u, estimator->get_trained_centers().n_elem, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { estimator->partial_train(X, mkcol({5, 6, 7, 8, 9})); }, SPOT);
+}
+
+TEST(test_train_cancelled) {
+    make_test_train_cancelled(1);
+}
+
+TEST(test_train_cancelled_async) {
+    make_test_train_cancelled(3);
+}
+
+TEST(test_train_cancelled_in_progress) {
+    auto estimator = make_cancelling_estimator(3);
+    const auto X = get_X();
+    estimator->train(X, mkcol({5, 6, 7, 8, 9}));
+    const auto centers = estimator->get_trained_centers();
+    densitas::cancellation_token token;
+    estimator->token = &token;
+    estimator->cancel_at = 2;
+    assert_false(estimator->train(X, mkcol({50, 60, 70, 80, 90}), token), SPOT);
+    assert_equal(2u, estimator->n_calls.load(), SPOT);
+    assert_equal_containers(centers, estimator->get_trained_centers(), SPOT);
+}
+
+void make_test_train_deadline_ahead(int threads)
+{
+    auto estimator = make_cancelling_estimator(3);
+    const auto X = get_X();
+    const auto y = mkcol({5, 6, 7, 8, 9});
+    densitas::cancellation_token token(std::chrono::steady_clock::now() + std::chrono::hours(1));
+    assert_true(estimator->train(X, y, token, threads), SPOT);
+    auto expected = make_cancelling_estimator(3);
+    expected->train(X, y);
+    assert_equal_containers(expected->get_trained_centers(), estimator->get_trained_centers(), SPOT);
+    assert_equal_containers(expected->predict(X), estimator->predict(X), SPOT);
+}
+
+TEST(test_train_deadline_ahead) {
+    make_test_train_deadline_ahead(1);
+}
+
+TEST(test_train_deadline_ahead_async) {
+    make_test_train_deadline_ahead(3);
+}
+
+void make_test_train_and_predict_async(int threads)
+{
+    auto estimator = make_cancelling_estimator(3);
+    const auto X = get_X();
+    const auto y = mkcol({5, 6, 7, 8, 9});
+    estimator->train_async(X, y, threads).get();
+    auto expected = make_cancelling_estimator(3);
+    expected->train(X, y);
+    assert_equal_containers(expected->get_trained_centers(), estimator->get_trained_centers(), SPOT);
+    std::vector<std::future<matrix_t>> futures;
+    for (int i=0; i<4; ++i) {
+        futures.push_back(estimator->predict_async(X, threads));
+    }
+    for (auto& future : futures) {
+        assert_equal_containers(expected->predict(X), future.get(), SPOT);
+    }
+}
+
+TEST(test_train_and_predict_async) {
+    make_test_train_and_predict_async(1);
+}
+
+TEST(test_train_and_predict_async_threaded) {
+    make_test_train_and_predict_async(3);
+}
+
+TEST(test_train_and_predict_async_on_executor) {
+    densitas::core::thread_pool executor{1};
+    auto estimator = make_cancelling_estimator(2);
+    const auto X = get_X();
+    estimator->train_async(executor, X, mkcol({5, 6, 7, 8, 9}), 2).get();
+    auto first = estimator->predict_async(executor, X, 2);
+    auto second = estimator->predict_async(executor, X, 2);
+    const auto expected = estimator->predict(X);
+    assert_equal_containers(expected, first.get(), SPOT);
+    assert_equal_containers(expected, second.get(), SPOT);
+}
+
+TEST(test_predict_async_error) {
+    auto estimator = make_cancelling_estimator(2);
+    auto future = estimator->predict_async(get_X());
+    assert_throw<densitas::densitas_error>([&future]() { future.get(); }, SPOT);
+}
+
+void make_test_predict_one(bool exact)
+{
+    auto estimator = train_estimator();
+    estimator->exact_predicted_quantiles(exact);
+    const auto X = get_X();
+    const auto expected = estimator->predict(X);
+    auto workspace = estimator->make_predict_workspace();
+    vector_t out;
+    for (std::size_t i=0; i<X.n_rows; ++i) {
+        auto row = densitas::core::extract_rows<double>(X, i, 1);
+        estimator->predict_one(row, out, workspace);
+        assert_equal_containers(densitas::core::extract_row<double, vector_t>(expected, i), out, SPOT);
+    }
+}
+
+TEST(test_predict_one) {
+    make_test_predict_one(true);
+}
+
+TEST(test_predict_one_not_exact) {
+    make_test_predict_one(false);
+}
+
+TEST(test_predict_one_reuses_memory) {
+    auto estimator = train_estimator();
+    auto workspace = estimator->make_predict_workspace();
+    assert_equal(2u, workspace.weights.n_elem, SPOT);
+    assert_greater_equal(workspace.scratch.order.capacity(), 2u, SPOT);
+    auto row = densitas::core::extract_rows<double>(get_X(), 0, 1);
+    vector_t out(3);
+    const auto out_data = out.memptr();
+    const auto weights_data = workspace.weights.memptr();
+    estimator->predict_one(row, out, workspace);
+    estimator->predict_one(row, out, workspace);
+    assert_true(out_data == out.memptr(), SPOT);
+    assert_true(weights_data == workspace.weights.memptr(), SPOT);
+}
+
+TEST(test_predict_one_with_several_rows) {
+    auto estimator = train_estimator();
+    auto workspace = estimator->make_predict_workspace();
+    auto X = get_X();
+    vector_t out;
+    assert_throw<densitas::densitas_error>([&]() { estimator->predict_one(X, out, workspace); }, SPOT);
+}
+
+template<typename VectorType, typename MatrixType, typename ElementType>
+struct typed_estimator_t : densitas::density_estimator<typed_estimator_t<VectorType, MatrixType, ElementType>, nearest_mean_model<VectorType, MatrixType, ElementType>, MatrixType, VectorType, ElementType> {
+
+    typedef densitas::density_estimator<typed_estimator_t, nearest_mean_model<VectorType, MatrixType, ElementType>, MatrixType, VectorType, ElementType> base_type;
+
+    typed_estimator_t()
+    : base_type{}
+    {}
+
+    typed_estimator_t(const nearest_mean_model<VectorType, MatrixType, ElementType>& model, std::size_t n_models)
+    : base_type{model, n_models}
+    {}
+
+};
+
+typedef typed_estimator_t<vector_t, matrix_t, double> double_estimator_t;
+
+typedef typed_estimator_t<float_vector_t, float_matrix_t, float> float_estimator_t;
+
+void make_test_float_matches_double(bool exact, int threads)
+{
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    float_matrix_t float_X;
+    float_vector_t float_y;
+    make_typed_data(float_X, float_y);
+    double_estimator_t estimator(nearest_mean_model<vector_t, matrix_t, double>(), 5);
+    estimator.exact_predicted_quantiles(exact);
+    estimator.train(X, y, threads);
+    float_estimator_t float_estimator(nearest_mean_model<float_vector_t, float_matrix_t, float>(), 5);
+    float_estimator.exact_predicted_quantiles(exact);
+    float_estimator.accuracy_predicted_quantiles(1e-2f);
+    float_estimator.train(float_X, float_y, threads);
+    const auto prediction = estimator.predict(X, threads);
+    const auto float_prediction = float_estimator.predict(float_X, threads);
+    assert_equal(prediction.n_rows, float_prediction.n_rows, SPOT);
+    assert_equal(prediction.n_cols, float_prediction.n_cols, SPOT);
+    for (std::size_t i=0; i<prediction.n_rows; ++i) {
+        for (std::size_t j=0; j<prediction.n_cols; ++j) {
+            assert_approx_equal(prediction(i, j), static_cast<double>(float_prediction(i, j)), 1e-4, SPOT);
+        }
+    }
+}
+
+TEST(test_float_matches_double) {
+    make_test_float_matches_double(true, 1);
+    make_test_float_matches_double(false, 1);
+}
+
+TEST(test_float_matches_double_async) {
+    make_test_float_matches_double(true, 3);
+    make_test_float_matches_double(false, 3);
+}
+
+TEST(test_float_predict_one) {
+    float_matrix_t X;
+    float_vector_t y;
+    make_typed_data(X, y);
+    float_estimator_t estimator(nearest_mean_model<float_vector_t, float_matrix_t, float>(), 5);
+    estimator.train(X, y);
+    const auto prediction = estimator.predict(X);
+    auto workspace = estimator.make_predict_workspace();
+    float_vector_t out;
+    auto row = densitas::core::extract_rows<float>(X, 7, 1);
+    estimator.predict_one(row, out, workspace);
+    for (std::size_t j=0; j<out.n_elem; ++j) {
+        assert_equal(prediction(7, j), out(j), SPOT);
+    }
+}
+
+TEST(test_float_typedefs) {
+    static_assert(std::is_same<float, typename float_estimator_t::element_type>::value, "");
+    static_assert(std::is_same<float_matrix_t, decltype(std::declval<float_estimator_t>().predict(std::declval<float_matrix_t>()))>::value, "");
+}
+
+void make_cdf_estimator(double_estimator_t& estimator, matrix_t& X)
+{
+    vector_t y;
+    make_typed_data(X, y);
+    estimator.set_models(nearest_mean_model<vector_t, matrix_t, double>(), 5);
+    estimator.predicted_quantiles(mkcol({0, 0.1, 0.5, 0.9}));
+    estimator.train(X, y);
+}
+
+TEST(test_predict_cdf_at_predicted_quantiles) {
+    double_estimator_t estimator;
+    matrix_t X;
+    make_cdf_estimator(estimator, X);
+    const auto prediction = estimator.predict(X);
+    for (std::size_t i=0; i<X.n_rows; i+=17) {
+        const auto row = densitas::core::extract_rows<double>(X, i, 1);
+        const auto grid = densitas::core::extract_row<double, vector_t>(prediction, i);
+        const auto cdf = estimator.predict_cdf(row, grid);
+        assert_equal(1u, cdf.n_rows, SPOT);
+        assert_equal(4u, cdf.n_cols, SPOT);
+        const auto probas = mkcol({0, 0.1, 0.5, 0.9});
+        for (std::size_t j=1; j<probas.n_elem; ++j) {
+            // the smallest center carries its weight as a point mass
+            if (grid(j) > grid(0))
+                assert_approx_equal(probas(j), cdf(0, j), 1e-9, SPOT);
+            else
+                assert_greater_equal(cdf(0, j), probas(j), SPOT);
+        }
+    }
+}
+
+TEST(test_predict_cdf_at_bin_edges) {
+    double_estimator_t estimator;
+    matrix_t X;
+    make_cdf_estimator(estimator, X);
+    const auto cdf = estimator.predict_cdf(X);
+    assert_equal(X.n_rows, cdf.n_rows, SPOT);
+    assert_equal(6u, cdf.n_cols, SPOT);
+    for (std::size_t i=0; i<cdf.n_rows; ++i) {
+        for (std::size_t j=1; j<cdf.n_cols; ++j) {
+            assert_greater_equal(cdf(i, j), cdf(i, j - 1), SPOT);
+        }
+        assert_approx_equal(1., cdf(i, 5), 1e-12, SPOT);
+    }
+}
+
+TEST(test_predict_density) {
+    double_estimator_t estimator;
+    matrix_t X;
+    make_cdf_estimator(estimator, X);
+    const auto grid = densitas::math::linspace<vector_t, double>(-1, 3, 9);
+    const auto cdf = estimator.predict_cdf(X, grid);
+    const auto density = estimator.predict_density(X, grid);
+    assert_equal(X.n_rows, density.n_rows, SPOT);
+    assert_equal(8u, density.n_cols, SPOT);
+    for (std::size_t i=0; i<density.n_rows; ++i) {
+        for (std::size_t j=0; j<density.n_cols; ++j) {
+            assert_greater_equal(density(i, j), 0., SPOT);
+            assert_approx_equal(cdf(i, j + 1) - cdf(i, j), density(i, j) * 0.5, 1e-12, SPOT);
+        }
+    }
+    const auto bin_density = estimator.predict_density(X);
+    assert_equal(5u, bin_density.n_cols, SPOT);
+}
+
+TEST(test_predict_cdf_threaded_and_batched) {
+    double_estimator_t estimator;
+    matrix_t X;
+    make_cdf_estimator(estimator, X);
+    const auto grid = mkcol({0, 0.5, 1, 1.5, 2});
+    const auto cdf = estimator.predict_cdf(X, grid);
+    const auto density = estimator.predict_density(X, grid);
+    assert_equal_containers(cdf, estimator.predict_cdf(X, grid, 4), SPOT);
+    assert_equal_containers(density, estimator.predict_density(X, grid, 4), SPOT);
+    estimator.predict_batch_size(8);
+    assert_equal_containers(cdf, estimator.predict_cdf(X, grid, 3), SPOT);
+    assert_equal_containers(density, estimator.predict_density(X, grid), SPOT);
+}
+
+TEST(test_predict_cdf_invalid) {
+    double_estimator_t estimator;
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    estimator.set_models(nearest_mean_model<vector_t, matrix_t, double>(), 5);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_cdf(X); }, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_density(X); }, SPOT);
+    estimator.train(X, y);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_cdf(X, vector_t{}); }, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_cdf(X, mkcol({1, 0})); }, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_density(X, mkcol({1})); }, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_density(X, mkcol({0, 1, 1})); }, SPOT);
+}
+
 TEST(test_number_of_models_too_small) {
     auto model = mock_model();
     assert_throw<densitas::densitas_error>([&]() { estimator_t(model, 1); }, SPOT);
@@ -129,6 +1264,14 @@ TEST(test_accuracy_predicted_quantiles_setter) {
     assert_equal(accuracy, estimator.get_accuracy_predicted_quantiles(), SPOT);
 }
 
+TEST(test_exact_predicted_quantiles_setter) {
+    auto model = mock_model();
+    estimator_t estimator(model, 2);
+    assert_true(estimator.get_exact_predicted_quantiles(), SPOT);
+    estimator.exact_predicted_quantiles(false);
+    assert_false(estimator.get_exact_predicted_quantiles(), SPOT);
+}
+
 TEST(test_clone) {
     auto model = mock_model();
     estimator_t estimator;
@@ -0,0 +1,108 @@
+#include "utils.hpp"
+
+
+COLLECTION(fixed_density_estimator) {
+
+typedef nearest_mean_model<vector_t, matrix_t, double> model_t;
+
+template<std::size_t NModels, std::size_t NQuantiles>
+struct estimator_t : densitas::fixed_density_estimator<estimator_t<NModels, NQuantiles>, model_t, matrix_t, vector_t, NModels, NQuantiles> {
+
+    typedef densitas::fixed_density_estimator<estimator_t, model_t, matrix_t, vector_t, NModels, NQuantiles> base_type;
+
+    estimator_t()
+    : base_type{}
+    {}
+
+    explicit
+    estimator_t(const model_t& model)
+    : base_type{model}
+    {}
+
+    estimator_t(const model_t& model, const typename base_type::quantile_array& quantiles)
+    : base_type{model, quantiles}
+    {}
+
+};
+
+TEST(test_predict_fixed_matches_predict) {
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    const std::array<double, 4> quantiles = {{0.1, 0.25, 0.5, 0.9}};
+    estimator_t<5, 4> estimator(model_t(), quantiles);
+    estimator.train(X, y);
+    const auto prediction = estimator.predict(X);
+    assert_equal(4u, prediction.n_cols, SPOT);
+    for (std::size_t i=0; i<X.n_rows; ++i) {
+        auto row = densitas::core::extract_rows<double>(X, i, 1);
+        const auto fixed = estimator.predict_fixed(row);
+        for (std::size_t j=0; j<fixed.size(); ++j) {
+            assert_approx_equal(prediction(i, j), fixed[j], 1e-12, SPOT);
+        }
+    }
+}
+
+TEST(test_default_quantiles) {
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    estimator_t<3, 3> estimator{model_t()};
+    estimator.train(X, y);
+    auto row = densitas::core::extract_rows<double>(X, 0, 1);
+    assert_equal(3u, estimator.predict_fixed(row).size(), SPOT);
+}
+
+TEST(test_default_quantiles_sized_from_n_quantiles) {
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    estimator_t<3, 2> estimator{model_t()};
+    estimator.train(X, y);
+    auto row = densitas::core::extract_rows<double>(X, 0, 1);
+    const auto fixed = estimator.predict_fixed(row);
+    const auto prediction = estimator.predict(row);
+    assert_equal(2u, prediction.n_cols, SPOT);
+    assert_approx_equal(prediction(0, 0), fixed[0], 1e-12, SPOT);
+    assert_approx_equal(prediction(0, 1), fixed[1], 1e-12, SPOT);
+    estimator_t<3, 1> median_estimator;
+    median_estimator.set_models(model_t());
+    median_estimator.train(X, y);
+    assert_equal(1u, median_estimator.predict_fixed(row).size(), SPOT);
+}
+
+TEST(test_quantiles_not_matching) {
+    estimator_t<3, 2> estimator{model_t()};
+    auto& base = static_cast<estimator_t<3, 2>::density_estimator_type&>(estimator);
+    assert_throw<densitas::densitas_error>([&]() { base.predicted_quantiles(mkcol({0.1, 0.5, 0.9})); }, SPOT);
+    base.predicted_quantiles(mkcol({0.2, 0.8}));
+}
+
+TEST(test_not_trained) {
+    estimator_t<3, 3> estimator{model_t()};
+    auto row = matrix_t(1, 2);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_fixed(row); }, SPOT);
+}
+
+TEST(test_several_rows) {
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    estimator_t<3, 3> estimator{model_t()};
+    estimator.train(X, y);
+    assert_throw<densitas::densitas_error>([&]() { estimator.predict_fixed(X); }, SPOT);
+}
+
+TEST(test_number_of_models_fixed) {
+    estimator_t<3, 3> estimator;
+    assert_throw<densitas::densitas_error>([&]() { estimator.density_estimator_type::set_models(model_t(), 4); }, SPOT);
+    estimator.set_models(model_t());
+    matrix_t X;
+    vector_t y;
+    make_typed_data(X, y);
+    estimator.train(X, y);
+    const auto cloned = estimator.clone();
+    assert_equal_containers(estimator.predict(X), cloned->predict(X), SPOT);
+}
+
+}
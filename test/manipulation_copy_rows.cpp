@@ -0,0 +1,55 @@
+#include "utils.hpp"
+
+
+COLLECTION(manipulation_copy_rows) {
+
+auto function = densitas::core::copy_rows<double, matrix_t>;
+
+matrix_t get_matrix()
+{
+    auto matrix = matrix_t(3, 3);
+    matrix.row(0) = mkrow({1, 2, 3});
+    matrix.row(1) = mkrow({10, 20, 30});
+    matrix.row(2) = mkrow({100, 200, 300});
+    return matrix;
+}
+
+TEST(test_happy_path) {
+    const auto matrix = get_matrix();
+    auto target = matrix_t(2, 3);
+    function(matrix, 1, 2, target);
+    assert_equal_containers(densitas::core::extract_rows<double>(matrix, 1, 2), target, SPOT);
+}
+
+TEST(test_into_larger_target) {
+    const auto matrix = get_matrix();
+    auto target = matrix_t(3, 3);
+    target.row(2) = mkrow({7, 8, 9});
+    function(matrix, 0, 2, target);
+    auto expected = get_matrix();
+    expected.row(2) = mkrow({7, 8, 9});
+    assert_equal_containers(expected, target, SPOT);
+}
+
+TEST(test_row_range_too_big) {
+    const auto matrix = get_matrix();
+    auto target = matrix_t(3, 3);
+    assert_throw<densitas::densitas_error>([&]() { function(matrix, 2, 2, target); }, SPOT);
+}
+
+TEST(test_target_too_small) {
+    const auto matrix = get_matrix();
+    auto too_few_rows = matrix_t(1, 3);
+    assert_throw<densitas::densitas_error>([&]() { function(matrix, 0, 2, too_few_rows); }, SPOT);
+    auto wrong_columns = matrix_t(2, 2);
+    assert_throw<densitas::densitas_error>([&]() { function(matrix, 0, 2, wrong_columns); }, SPOT);
+}
+
+TEST(test_without_layout) {
+    const auto matrix = get_matrix();
+    plain_matrix target(2, 3);
+    densitas::core::copy_rows<double>(plain_matrix(matrix), 1, 2, target);
+    assert_equal_containers(densitas::core::extract_rows<double>(matrix, 1, 2), target.to_matrix(), SPOT);
+}
+
+}
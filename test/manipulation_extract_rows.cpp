@@ -0,0 +1,43 @@
+#include "utils.hpp"
+
+
+COLLECTION(manipulation_extract_rows) {
+
+auto function = densitas::core::extract_rows<double, matrix_t>;
+
+TEST(test_happy_path) {
+    const auto row1 = mkrow({1, 2, 3});
+    const auto row2 = mkrow({10, 20, 30});
+    const auto row3 = mkrow({100, 200, 300});
+    auto matrix = matrix_t(3, 3);
+    matrix.row(0) = row1;
+    matrix.row(1) = row2;
+    matrix.row(2) = row3;
+    const auto rows = function(matrix, 1, 2);
+    auto expected = matrix_t(2, 3);
+    expected.row(0) = row2;
+    expected.row(1) = row3;
+    assert_equal_containers(expected, rows, SPOT);
+}
+
+TEST(test_no_rows) {
+    const auto matrix = matrix_t(2, 3);
+    const auto rows = function(matrix, 1, 0);
+    assert_equal(0u, rows.n_rows, SPOT);
+    assert_equal(3u, rows.n_cols, SPOT);
+}
+
+TEST(test_row_range_too_big) {
+    const auto matrix = matrix_t(2, 3);
+    assert_throw<densitas::densitas_error>([&]() { function(matrix, 1, 2); }, SPOT);
+}
+
+TEST(test_without_layout) {
+    auto matrix = matrix_t(3, 2);
+    matrix.row(0) = mkrow({1, 2});
+    matrix.row(1) = mkrow({3, 4});
+    matrix.row(2) = mkrow({5, 6});
+    const auto rows = densitas::core::extract_rows<double>(plain_matrix(matrix), 1, 2);
+    assert_equal_containers(function(matrix, 1, 2), rows.to_matrix(), SPOT);
+}
+}
@@ -0,0 +1,76 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_accumulate_bins) {
+
+auto function = densitas::math::accumulate_bins<double, vector_t>;
+
+TEST(test_happy_path) {
+    const auto data = mkcol({0, 0.2, 0.8, 1, 1.5, 2});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}, {0, 0}, {0, 0}, {0, 1}, {1, 1}, {1, 1}};
+    std::vector<double> accumulator = {1, 2};
+    std::vector<std::size_t> counter = {3, 4};
+    function(data, bins, accumulator, counter, 1);
+    const std::vector<double> expected_accumulator = {3, 6.5};
+    const std::vector<std::size_t> expected_counter = {7, 7};
+    assert_equal_containers(expected_accumulator, accumulator, SPOT);
+    assert_equal_containers(expected_counter, counter, SPOT);
+}
+
+void make_test_matches_single_threaded(int threads)
+{
+    vector_t data(1000);
+    for (std::size_t i=0; i<data.n_elem; ++i) {
+        data(i) = static_cast<double>((i * 7919) % 1000);
+    }
+    const auto quantiles = densitas::math::quantiles<double>(data, densitas::math::linspace<vector_t>(0., 1., 11));
+    const auto bins = densitas::math::bin_ranges<double>(data, quantiles);
+    std::vector<double> expected_accumulator(10, 0.);
+    std::vector<std::size_t> expected_counter(10, 0);
+    function(data, bins, expected_accumulator, expected_counter, 1);
+    std::vector<double> accumulator(10, 0.);
+    std::vector<std::size_t> counter(10, 0);
+    function(data, bins, accumulator, counter, threads);
+    assert_equal_containers(expected_accumulator, accumulator, SPOT);
+    assert_equal_containers(expected_counter, counter, SPOT);
+}
+
+TEST(test_matches_single_threaded) {
+    make_test_matches_single_threaded(4);
+}
+
+TEST(test_zero_size_data) {
+    const auto data = mkcol({});
+    const std::vector<densitas::math::bin_range> bins;
+    std::vector<double> accumulator = {1};
+    std::vector<std::size_t> counter = {2};
+    function(data, bins, accumulator, counter, 1);
+    assert_equal(1., accumulator[0], SPOT);
+    assert_equal(2u, counter[0], SPOT);
+}
+
+TEST(test_data_and_bins_different_size) {
+    const auto data = mkcol({0, 1});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}};
+    std::vector<double> accumulator(1, 0.);
+    std::vector<std::size_t> counter(1, 0);
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, accumulator, counter, 1); }, SPOT);
+}
+
+TEST(test_no_bins) {
+    const auto data = mkcol({0});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}};
+    std::vector<double> accumulator;
+    std::vector<std::size_t> counter;
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, accumulator, counter, 1); }, SPOT);
+}
+
+TEST(test_accumulator_and_counter_different_size) {
+    const auto data = mkcol({0});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}};
+    std::vector<double> accumulator(2, 0.);
+    std::vector<std::size_t> counter(1, 0);
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, accumulator, counter, 1); }, SPOT);
+}
+
+}
@@ -0,0 +1,62 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_bin_ranges) {
+
+auto function = densitas::math::bin_ranges<double, vector_t>;
+
+void assert_bins(const std::vector<densitas::math::bin_range>& expected, const std::vector<densitas::math::bin_range>& actual, const std::string& spot)
+{
+    assert_equal(expected.size(), actual.size(), spot);
+    for (std::size_t i=0; i<expected.size(); ++i) {
+        assert_equal(expected[i].first, actual[i].first, spot);
+        assert_equal(expected[i].last, actual[i].last, spot);
+    }
+}
+
+TEST(test_happy_path) {
+    const auto data = mkcol({0, 0.2, 0.8, 1, 1.5, 2, 2.5, 3});
+    const auto quantiles = mkcol({0, 1, 2, 3});
+    const auto bins = function(data, quantiles);
+    const std::vector<densitas::math::bin_range> expected = {{0, 0}, {0, 0}, {0, 0}, {0, 1}, {1, 1}, {1, 2}, {2, 2}, {2, 2}};
+    assert_bins(expected, bins, SPOT);
+}
+
+TEST(test_matches_classification_target) {
+    const auto data = mkcol({3, 1, 4, 1, 5, 9, 2, 6, 5, 3, 5});
+    const auto quantiles = mkcol({1, 2, 3, 3, 5, 9});
+    const auto bins = function(data, quantiles);
+    for (std::size_t j=0; j<quantiles.n_elem - 1; ++j) {
+        const auto expected = densitas::math::make_classification_target<mock_model>(data, quantiles(j), quantiles(j + 1));
+        const auto target = densitas::math::make_classification_target_from_bins<mock_model, double, vector_t>(bins, j);
+        assert_equal_containers(expected, target, SPOT);
+    }
+}
+
+TEST(test_values_outside_of_bins) {
+    const auto data = mkcol({-1, 4});
+    const auto quantiles = mkcol({0, 1, 2, 3});
+    const auto bins = function(data, quantiles);
+    const std::vector<densitas::math::bin_range> expected = {{0, 0}, {2, 2}};
+    assert_bins(expected, bins, SPOT);
+}
+
+TEST(test_zero_size_data) {
+    const auto data = mkcol({});
+    const auto quantiles = mkcol({0, 1});
+    assert_equal(0u, function(data, quantiles).size(), SPOT);
+}
+
+TEST(test_only_one_quantile) {
+    const auto data = mkcol({0, 0.2, 1});
+    const auto quantiles = mkcol({1});
+    assert_throw<densitas::densitas_error>([&]() { function(data, quantiles); }, SPOT);
+}
+
+TEST(test_too_many_bins) {
+    const auto data = mkcol({0.5});
+    const auto quantiles = densitas::math::linspace<vector_t>(0., 1., 65538);
+    assert_throw<densitas::densitas_error>([&]() { function(data, quantiles); }, SPOT);
+}
+
+}
@@ -0,0 +1,54 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_cdf_weighted_exact) {
+
+TEST(test_happy_path) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5, 0.5});
+    const auto cdf = densitas::math::cdf_weighted_exact<double>(data, weights, mkcol({0, 1, 1.5, 2, 2.2, 3, 4}));
+    assert_equal(7u, cdf.n_elem, SPOT);
+    assert_approx_equal(0., cdf(0), 1e-15, SPOT);
+    assert_approx_equal(0.5, cdf(1), 1e-15, SPOT);
+    assert_approx_equal(0.625, cdf(2), 1e-15, SPOT);
+    assert_approx_equal(0.75, cdf(3), 1e-15, SPOT);
+    assert_approx_equal(0.8, cdf(4), 1e-15, SPOT);
+    assert_approx_equal(1., cdf(5), 1e-15, SPOT);
+    assert_approx_equal(1., cdf(6), 1e-15, SPOT);
+}
+
+TEST(test_inverts_quantiles_weighted_exact) {
+    const auto data = mkcol({3, 1, 4, 2, 5});
+    const auto weights = mkcol({0.1, 0.4, 0.2, 0.3, 0.6});
+    const auto probas = mkcol({0.3, 0.5, 0.75, 0.95});
+    const auto quantiles = densitas::math::quantiles_weighted_exact<double>(data, weights, probas);
+    const auto cdf = densitas::math::cdf_weighted_exact<double>(data, weights, quantiles);
+    for (std::size_t i=0; i<probas.n_elem; ++i) {
+        assert_approx_equal(probas(i), cdf(i), 1e-12, SPOT);
+    }
+}
+
+TEST(test_equal_weights_if_all_zero) {
+    const auto cdf = densitas::math::cdf_weighted_exact<double>(mkcol({1, 2, 3, 4}), mkcol({0, 0, -1, 0}), mkcol({1, 2.5, 4}));
+    assert_approx_equal(0.25, cdf(0), 1e-15, SPOT);
+    assert_approx_equal(0.625, cdf(1), 1e-15, SPOT);
+    assert_approx_equal(1., cdf(2), 1e-15, SPOT);
+}
+
+TEST(test_into) {
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t cdf(2);
+    densitas::math::cdf_weighted_exact_into<double>(mkcol({2, 1}), mkcol({1, 1}), mkcol({1.5, 2}), scratch, cdf);
+    assert_approx_equal(0.75, cdf(0), 1e-15, SPOT);
+    assert_approx_equal(1., cdf(1), 1e-15, SPOT);
+    vector_t wrong(3);
+    assert_throw<densitas::densitas_error>([&]() { densitas::math::cdf_weighted_exact_into<double>(mkcol({2, 1}), mkcol({1, 1}), mkcol({1.5, 2}), scratch, wrong); }, SPOT);
+}
+
+TEST(test_throws) {
+    assert_throw<densitas::densitas_error>([]() { densitas::math::cdf_weighted_exact<double>(mkcol({1, 2}), mkcol({1}), mkcol({1})); }, SPOT);
+    assert_throw<densitas::densitas_error>([]() { densitas::math::cdf_weighted_exact<double>(vector_t{}, vector_t{}, mkcol({1})); }, SPOT);
+    assert_throw<densitas::densitas_error>([]() { densitas::math::cdf_weighted_exact<double>(mkcol({1, 2}), mkcol({1, 1}), mkcol({2, 1})); }, SPOT);
+}
+
+}
@@ -13,6 +13,30 @@ TEST(test_happy_path) {
     assert_equal_containers(expected, centers, SPOT);
 }
 
+TEST(test_values_outside_of_bins) {
+    const auto data = mkcol({-1, 0.5, 1.5, 3});
+    const auto quantiles = mkcol({0, 1, 2});
+    const auto centers = function(data, quantiles);
+    const auto expected = mkcol({0.5, 1.5});
+    assert_equal_containers(expected, centers, SPOT);
+}
+
+TEST(test_with_equal_quantiles) {
+    const auto data = mkcol({1, 2, 2, 2, 3});
+    const auto quantiles = mkcol({1, 2, 2, 3});
+    const auto centers = function(data, quantiles);
+    const auto expected = mkcol({1.75, 2, 2.25});
+    assert_equal_containers(expected, centers, SPOT);
+}
+
+TEST(test_empty_bin) {
+    const auto data = mkcol({0, 3});
+    const auto quantiles = mkcol({0, 1, 2, 3});
+    const auto centers = function(data, quantiles);
+    const auto expected = mkcol({0, 0, 3});
+    assert_equal_containers(expected, centers, SPOT);
+}
+
 TEST(test_only_one_value) {
     const auto data = mkcol({0, 0.2, 1});
     const auto quantiles = mkcol({1});
@@ -31,4 +55,10 @@ TEST(test_zero_size_data) {
     assert_throw<densitas::densitas_error>([&]() { function(data, quantiles); });
 }
 
+TEST(test_without_contiguous_memory) {
+    const auto data = mkcol({1, 2, 2, 2, 3});
+    const auto quantiles = mkcol({1, 2, 2, 3});
+    const auto centers = densitas::math::centers<double>(plain_vector(data), plain_vector(quantiles));
+    assert_equal_containers(function(data, quantiles), centers.to_vector(), SPOT);
+}
 }
@@ -0,0 +1,55 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_centers_from_bins) {
+
+auto function = densitas::math::centers_from_bins<double, vector_t>;
+
+TEST(test_happy_path) {
+    const auto data = mkcol({0, 0.2, 0.8, 1, 1.5, 2});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}, {0, 0}, {0, 0}, {0, 1}, {1, 1}, {1, 1}};
+    const auto centers = function(data, bins, 2, 1);
+    const auto expected = mkcol({0.5, 1.5});
+    assert_equal_containers(expected, centers, SPOT);
+}
+
+void make_test_matches_centers(int threads)
+{
+    vector_t data(1000);
+    for (std::size_t i=0; i<data.n_elem; ++i) {
+        data(i) = static_cast<double>((i * 7919) % 1000);
+    }
+    const auto quantiles = densitas::math::quantiles<double>(data, densitas::math::linspace<vector_t>(0., 1., 11));
+    const auto bins = densitas::math::bin_ranges<double>(data, quantiles);
+    const auto centers = function(data, bins, 10, threads);
+    const auto expected = densitas::math::centers<double>(data, quantiles);
+    assert_equal_containers(expected, centers, SPOT);
+}
+
+TEST(test_matches_centers) {
+    make_test_matches_centers(1);
+}
+
+TEST(test_matches_centers_async) {
+    make_test_matches_centers(4);
+}
+
+TEST(test_data_and_bins_different_size) {
+    const auto data = mkcol({0, 1});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}};
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, 1, 1); }, SPOT);
+}
+
+TEST(test_zero_size_data) {
+    const auto data = mkcol({});
+    const std::vector<densitas::math::bin_range> bins;
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, 1, 1); }, SPOT);
+}
+
+TEST(test_no_bins) {
+    const auto data = mkcol({0});
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}};
+    assert_throw<densitas::densitas_error>([&]() { function(data, bins, 0, 1); }, SPOT);
+}
+
+}
@@ -0,0 +1,28 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_make_classification_target_from_bins) {
+
+auto function = densitas::math::make_classification_target_from_bins<mock_model, double, vector_t>;
+
+TEST(test_happy_path) {
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}, {0, 1}, {1, 1}, {2, 2}};
+    const auto target = function(bins, 1);
+    const auto expected = mkcol({dno, dyes, dyes, dno});
+    assert_equal_containers(expected, target, SPOT);
+}
+
+TEST(test_with_no_bins) {
+    const auto target = function({}, 1);
+    const auto expected = mkcol({});
+    assert_equal_containers(expected, target, SPOT);
+}
+
+TEST(test_all_no) {
+    const std::vector<densitas::math::bin_range> bins = {{0, 0}, {1, 1}};
+    const auto target = function(bins, 2);
+    const auto expected = mkcol({dno, dno});
+    assert_equal_containers(expected, target, SPOT);
+}
+
+}
@@ -22,4 +22,74 @@ TEST(test_with_no_probas) {
     assert_equal_containers(expected, quantiles, SPOT);
 }
 
+TEST(test_matches_quantile) {
+    const auto data = mkcol({4.7, 1, 3.1, 2, 5, 1.5, 2.7, 4, 3, 2, 4});
+    const auto probas = mkcol({0.95, 0, 0.3, 0.05, 0.5, 0.5, 1, 0.71, 0.1, 0.99, 0.2});
+    const auto quantiles = function(data, probas);
+    for (std::size_t i=0; i<probas.n_elem; ++i) {
+        auto values = std::vector<double>(data.begin(), data.end());
+        const auto expected = densitas::math::quantile(values, probas(i));
+        assert_equal(expected, quantiles(i), SPOT);
+    }
+}
+
+TEST(test_with_many_probas) {
+    vector_t data(1000);
+    for (std::size_t i=0; i<data.n_elem; ++i) {
+        data(i) = static_cast<double>((i * 7919) % 1000);
+    }
+    const auto probas = densitas::math::linspace<vector_t>(0., 1., 101);
+    const auto quantiles = function(data, probas);
+    for (std::size_t i=0; i<probas.n_elem; ++i) {
+        auto values = std::vector<double>(data.begin(), data.end());
+        const auto expected = densitas::math::quantile(values, probas(i));
+        assert_equal(expected, quantiles(i), SPOT);
+    }
+}
+
+TEST(test_vector_with_no_contents) {
+    const auto data = mkcol({});
+    const auto probas = mkcol({0.5});
+    assert_throw<densitas::densitas_error>([&]() { function(data, probas); }, SPOT);
+}
+
+TEST(test_proba_too_big) {
+    const auto data = mkcol({1, 2, 3});
+    const auto probas = mkcol({0.5, 1.1});
+    assert_throw<densitas::densitas_error>([&]() { function(data, probas); }, SPOT);
+}
+
+TEST(test_proba_too_small) {
+    const auto data = mkcol({1, 2, 3});
+    const auto probas = mkcol({-0.1});
+    assert_throw<densitas::densitas_error>([&]() { function(data, probas); }, SPOT);
+}
+
+TEST(test_without_contiguous_memory) {
+    const auto data = mkcol({3, 1, 4, 1, 5, 9, 2, 6});
+    const auto probas = mkcol({0.1, 0.5, 0.9});
+    const auto quantiles = densitas::math::quantiles<double>(plain_vector(data), plain_vector(probas));
+    assert_equal_containers(function(data, probas), quantiles.to_vector(), SPOT);
+}
+TEST(test_into_reuses_scratch) {
+    const auto data = mkcol({3, 1, 4, 1, 5, 9, 2, 6});
+    const auto probas = mkcol({0.1, 0.5, 0.9});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(3);
+    densitas::math::quantiles_into<double>(data, probas, scratch, quantiles);
+    assert_equal_containers(function(data, probas), quantiles, SPOT);
+    const auto values = scratch.values.data();
+    densitas::math::quantiles_into<double>(data, probas, scratch, quantiles);
+    assert_true(values == scratch.values.data(), SPOT);
+    assert_equal_containers(function(data, probas), quantiles, SPOT);
+}
+
+TEST(test_into_with_wrong_size) {
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(2);
+    assert_throw<densitas::densitas_error>([&]() {
+        densitas::math::quantiles_into<double>(mkcol({1, 2, 3}), mkcol({0.5}), scratch, quantiles);
+    }, SPOT);
+}
+
 }
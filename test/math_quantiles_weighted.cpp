@@ -47,4 +47,26 @@ TEST(test_accuracy_too_small) {
     assert_throw<densitas::densitas_error>([&]() { function(data, weights, probas, 0); });
 }
 
+TEST(test_into_matches) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5, 0.5});
+    const auto probas = mkcol({0, 0.8});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(2);
+    for (int i=0; i<2; ++i) {
+        densitas::math::quantiles_weighted_into<double>(data, weights, probas, 0.1, scratch, quantiles);
+        assert_equal_containers(function(data, weights, probas, 0.1), quantiles, SPOT);
+    }
+    assert_equal(3u, scratch.counts.size(), SPOT);
+}
+
+TEST(test_into_with_wrong_size) {
+    const auto data = mkcol({1, 2, 3});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(1);
+    assert_throw<densitas::densitas_error>([&]() {
+        densitas::math::quantiles_weighted_into<double>(data, data, mkcol({0.1, 0.5}), 0.1, scratch, quantiles);
+    }, SPOT);
+}
+
 }
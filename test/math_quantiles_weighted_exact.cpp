@@ -0,0 +1,130 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_quantiles_weighted_exact) {
+
+auto function = densitas::math::quantiles_weighted_exact<double, vector_t>;
+
+TEST(test_happy_path) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5, 0.5});
+    const auto probas = mkcol({0, 0.8});
+    const auto quantiles = function(data, weights, probas);
+    const auto eps = 1e-15;
+    const auto expected = mkcol({1, 2.2});
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_equal_weights_match_quantiles) {
+    const auto data = mkcol({1, 1.5, 2, 2.7, 3, 3.1, 4, 4.7, 5});
+    const auto weights = mkcol({0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3, 0.3});
+    const auto probas = mkcol({0, 0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9, 1});
+    const auto quantiles = function(data, weights, probas);
+    const auto expected = densitas::math::quantiles<double>(data, probas);
+    const auto eps = 1e-12;
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_interpolation_across_cumulative_weights) {
+    const auto data = mkcol({1, 2, 3, 4});
+    const auto weights = mkcol({0.25, 0.75, 0.5, 0.25});
+    const auto probas = mkcol({0.1, 0.25, 0.5, 0.75, 0.95});
+    const auto quantiles = function(data, weights, probas);
+    const auto eps = 1e-12;
+    const auto expected = mkcol({1, 1.25, 1 + 0.625/0.75, 2.625, 3.65});
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_unsorted_data) {
+    const auto data = mkcol({3, 1, 2});
+    const auto weights = mkcol({0.5, 1, 0.5});
+    const auto probas = mkcol({0, 0.8});
+    const auto quantiles = function(data, weights, probas);
+    const auto eps = 1e-15;
+    const auto expected = mkcol({1, 2.2});
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_zero_weights_are_skipped) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0, 1});
+    const auto probas = mkcol({0.5, 0.6, 1});
+    const auto quantiles = function(data, weights, probas);
+    const auto eps = 1e-15;
+    const auto expected = mkcol({1, 1.4, 3});
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_all_weights_zero) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({0, 0, 0});
+    const auto probas = mkcol({0, 0.8});
+    const auto quantiles = function(data, weights, probas);
+    const auto eps = 1e-15;
+    const auto expected = mkcol({1, 2.4});
+    assert_approx_equal_containers(expected, quantiles, eps, SPOT);
+}
+
+TEST(test_vector_and_weights_different_size) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5});
+    const auto probas = mkcol({0, 0.8});
+    assert_throw<densitas::densitas_error>([&]() { function(data, weights, probas); }, SPOT);
+}
+
+TEST(test_vector_with_no_contents) {
+    const auto data = mkcol({});
+    const auto weights = mkcol({});
+    const auto probas = mkcol({0.5});
+    assert_throw<densitas::densitas_error>([&]() { function(data, weights, probas); }, SPOT);
+}
+
+TEST(test_proba_too_big) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5, 0.5});
+    const auto probas = mkcol({1.1});
+    assert_throw<densitas::densitas_error>([&]() { function(data, weights, probas); }, SPOT);
+}
+
+TEST(test_proba_too_small) {
+    const auto data = mkcol({1, 2, 3});
+    const auto weights = mkcol({1, 0.5, 0.5});
+    const auto probas = mkcol({-0.1});
+    assert_throw<densitas::densitas_error>([&]() { function(data, weights, probas); }, SPOT);
+}
+
+TEST(test_into_matches) {
+    const auto data = mkcol({3, 1, 2});
+    const auto weights = mkcol({0.5, 1, 0.5});
+    const auto probas = mkcol({0, 0.5, 1});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(3);
+    densitas::math::quantiles_weighted_exact_into<double>(data, weights, probas, scratch, quantiles);
+    assert_equal_containers(function(data, weights, probas), quantiles, SPOT);
+    assert_equal(3u, scratch.order.size(), SPOT);
+}
+
+TEST(test_into_reuses_order) {
+    const auto data = mkcol({2, 0, 1, 0, 2});
+    const auto weights = mkcol({0.5, 1, 0.5, 0, 1});
+    const auto probas = mkcol({0.1, 0.5, 0.9});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(3);
+    densitas::math::quantiles_weighted_exact_into<double>(data, weights, probas, scratch, quantiles);
+    assert_equal_containers(std::vector<std::size_t>({1, 3, 2, 0, 4}), scratch.order, SPOT);
+    const auto order_data = scratch.order.data();
+    densitas::math::quantiles_weighted_exact_into<double>(data, weights, probas, scratch, quantiles);
+    assert_true(order_data == scratch.order.data(), SPOT);
+    assert_equal_containers(function(data, weights, probas), quantiles, SPOT);
+}
+
+TEST(test_into_with_wrong_size) {
+    const auto data = mkcol({1, 2, 3});
+    densitas::math::scratch_buffers<double> scratch{};
+    vector_t quantiles(1);
+    assert_throw<densitas::densitas_error>([&]() {
+        densitas::math::quantiles_weighted_exact_into<double>(data, data, mkcol({0.1, 0.5}), scratch, quantiles);
+    }, SPOT);
+}
+
+}
@@ -0,0 +1,60 @@
+#include "utils.hpp"
+
+
+COLLECTION(math_quantiles_weighted_exact_fixed) {
+
+template<std::size_t N>
+std::array<double, N> to_array(const vector_t& vector)
+{
+    std::array<double, N> array;
+    std::copy(vector.begin(), vector.end(), array.begin());
+    return array;
+}
+
+template<std::size_t N, std::size_t NProbas>
+void assert_matches_exact(const vector_t& data, const vector_t& weights, const vector_t& probas)
+{
+    const auto expected = densitas::math::quantiles_weighted_exact<double>(data, weights, probas);
+    const auto quantiles = densitas::math::quantiles_weighted_exact_fixed<double>(to_array<N>(data), to_array<N>(weights), to_array<NProbas>(probas));
+    for (std::size_t i=0; i<NProbas; ++i) {
+        assert_approx_equal(expected(i), quantiles[i], 1e-12, SPOT);
+    }
+}
+
+TEST(test_happy_path) {
+    const std::array<double, 3> data = {{1, 2, 3}};
+    const std::array<double, 3> weights = {{1, 0.5, 0.5}};
+    const std::array<double, 2> probas = {{0, 0.8}};
+    const auto quantiles = densitas::math::quantiles_weighted_exact_fixed<double>(data, weights, probas);
+    assert_approx_equal(1., quantiles[0], 1e-15, SPOT);
+    assert_approx_equal(2.2, quantiles[1], 1e-15, SPOT);
+}
+
+TEST(test_matches_exact) {
+    assert_matches_exact<4, 5>(mkcol({1, 2, 3, 4}), mkcol({0.25, 0.75, 0.5, 0.25}), mkcol({0, 0.1, 0.5, 0.9, 1}));
+}
+
+TEST(test_matches_exact_unsorted) {
+    assert_matches_exact<5, 3>(mkcol({3, 1, 4, 1, 5}), mkcol({0.1, 0.4, 0.2, 0.3, 0.6}), mkcol({0.05, 0.5, 0.95}));
+}
+
+TEST(test_matches_exact_with_zero_and_negative_weights) {
+    assert_matches_exact<4, 3>(mkcol({1, 2, 3, 4}), mkcol({0, -1, 0.5, 0.5}), mkcol({0, 0.5, 1}));
+    assert_matches_exact<3, 3>(mkcol({1, 2, 3}), mkcol({0, 0, 0}), mkcol({0, 0.5, 1}));
+}
+
+TEST(test_float) {
+    const std::array<float, 3> data = {{1, 2, 3}};
+    const std::array<float, 3> weights = {{1, 0.5f, 0.5f}};
+    const std::array<float, 1> probas = {{0.8f}};
+    const auto quantiles = densitas::math::quantiles_weighted_exact_fixed<float>(data, weights, probas);
+    assert_approx_equal(2.2f, quantiles[0], 1e-6f, SPOT);
+}
+
+TEST(test_proba_out_of_range) {
+    const std::array<double, 3> data = {{1, 2, 3}};
+    const std::array<double, 1> probas = {{1.1}};
+    assert_throw<densitas::densitas_error>([&]() { densitas::math::quantiles_weighted_exact_fixed<double>(data, data, probas); }, SPOT);
+}
+
+}
@@ -39,6 +39,20 @@ public:
 
 };
 
+class memptr_matrix : public mock_matrix {
+public:
+
+    memptr_matrix(std::size_t n_rows, std::size_t n_cols)
+        : mock_matrix(n_rows, n_cols)
+    {}
+
+    const double* memptr() const
+    {
+        return &value_;
+    }
+
+};
+
 
 COLLECTION(matrix_adapter) {
 
@@ -84,4 +98,69 @@ TEST(test_set_element) {
     assert_equal(col, matrix.col_index_used_, SPOT);
 }
 
+TEST(test_get_row) {
+    auto matrix = matrix_t(2, 3);
+    matrix.row(0) = mkrow({1, 2, 3});
+    matrix.row(1) = mkrow({10, 20, 30});
+    const auto row = densitas::matrix_adapter::get_row<double>(matrix, 1);
+    auto expected = matrix_t(1, 3);
+    expected.row(0) = mkrow({10, 20, 30});
+    assert_equal_containers(expected, row, SPOT);
+}
+
+TEST(test_get_row_into) {
+    auto matrix = matrix_t(2, 3);
+    matrix.row(0) = mkrow({1, 2, 3});
+    matrix.row(1) = mkrow({10, 20, 30});
+    auto row = matrix_t(0, 0);
+    densitas::matrix_adapter::get_row_into<double>(matrix, 1, row);
+    auto expected = matrix_t(1, 3);
+    expected.row(0) = mkrow({10, 20, 30});
+    assert_equal_containers(expected, row, SPOT);
+    const auto row_data = row.memptr();
+    densitas::matrix_adapter::get_row_into<double>(matrix, 0, row);
+    expected.row(0) = mkrow({1, 2, 3});
+    assert_equal_containers(expected, row, SPOT);
+    assert_true(row_data == row.memptr(), SPOT);
+}
+
+TEST(test_layout_without_contiguous_memory) {
+    const mock_matrix matrix(2, 3);
+    const auto layout = densitas::matrix_adapter::layout<double>(matrix);
+    assert_true(layout.data == nullptr, SPOT);
+}
+
+TEST(test_layout_without_column_major_memptr) {
+    const memptr_matrix matrix(2, 3);
+    assert_false(densitas::matrix_adapter::column_major_memptr<memptr_matrix>::value, SPOT);
+    assert_true(densitas::matrix_adapter::layout<double>(matrix).data == nullptr, SPOT);
+}
+
+TEST(test_layout_column_major) {
+    auto matrix = matrix_t(2, 3);
+    matrix.row(0) = mkrow({1, 2, 3});
+    matrix.row(1) = mkrow({10, 20, 30});
+    const auto layout = densitas::matrix_adapter::layout<double>(matrix);
+    assert_equal(matrix.memptr(), layout.data, SPOT);
+    assert_equal(1u, layout.row_stride, SPOT);
+    assert_equal(2u, layout.column_stride, SPOT);
+    assert_equal(30, layout.data[1*layout.row_stride + 2*layout.column_stride], SPOT);
+}
+
+TEST(test_mutable_layout) {
+    auto matrix = matrix_t(2, 3);
+    const auto layout = densitas::matrix_adapter::mutable_layout<double>(matrix);
+    layout.data[1*layout.row_stride + 2*layout.column_stride] = 42;
+    assert_equal(42, matrix(1, 2), SPOT);
+}
+
+TEST(test_get_row_without_layout) {
+    auto matrix = matrix_t(2, 3);
+    matrix.row(0) = mkrow({1, 2, 3});
+    matrix.row(1) = mkrow({10, 20, 30});
+    const auto row = densitas::matrix_adapter::get_row<double>(plain_matrix(matrix), 1);
+    auto expected = matrix_t(1, 3);
+    expected.row(0) = mkrow({10, 20, 30});
+    assert_equal_containers(expected, row.to_matrix(), SPOT);
+}
 }
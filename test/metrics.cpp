@@ -0,0 +1,89 @@
+#include "utils.hpp"
+
+
+COLLECTION(metrics) {
+
+typedef densitas::metrics::phase phase;
+
+TEST(test_empty) {
+    densitas::metrics metrics;
+    const auto summary = metrics.get(phase::bin_edges);
+    assert_equal(0u, summary.count, SPOT);
+    assert_equal(0., summary.total_seconds, SPOT);
+    assert_equal(0u, metrics.n_models(phase::model_training), SPOT);
+}
+
+TEST(test_record) {
+    densitas::metrics metrics;
+    metrics.record(phase::centers, 3e-6);
+    metrics.record(phase::centers, 0.5e-6);
+    const auto summary = metrics.get(phase::centers);
+    assert_equal(2u, summary.count, SPOT);
+    assert_approx_equal(3.5e-6, summary.total_seconds, 1e-12, SPOT);
+    assert_equal(0.5e-6, summary.min_seconds, SPOT);
+    assert_equal(3e-6, summary.max_seconds, SPOT);
+    assert_equal(1u, summary.histogram[0], SPOT);
+    assert_equal(1u, summary.histogram[2], SPOT);
+    assert_equal(0u, metrics.get(phase::bin_edges).count, SPOT);
+}
+
+TEST(test_record_for_model) {
+    densitas::metrics metrics;
+    metrics.record(phase::model_training, 2, 1.);
+    metrics.record(phase::model_training, 0, 2.);
+    assert_equal(3u, metrics.n_models(phase::model_training), SPOT);
+    assert_equal(1., metrics.get(phase::model_training, 2).total_seconds, SPOT);
+    assert_equal(2., metrics.get(phase::model_training, 0).total_seconds, SPOT);
+    assert_equal(0u, metrics.get(phase::model_training, 1).count, SPOT);
+    assert_equal(0u, metrics.get(phase::model_training, 5).count, SPOT);
+    const auto summary = metrics.get(phase::model_training);
+    assert_equal(2u, summary.count, SPOT);
+    assert_equal(3., summary.total_seconds, SPOT);
+}
+
+TEST(test_merge) {
+    densitas::metrics metrics;
+    metrics.record(phase::model_scoring, 0, 1.);
+    densitas::metrics other;
+    other.record(phase::model_scoring, 1, 0.5);
+    other.record(phase::model_scoring, 0, 3.);
+    metrics.merge(other);
+    assert_equal(2u, metrics.n_models(phase::model_scoring), SPOT);
+    const auto first = metrics.get(phase::model_scoring, 0);
+    assert_equal(2u, first.count, SPOT);
+    assert_equal(1., first.min_seconds, SPOT);
+    assert_equal(3., first.max_seconds, SPOT);
+    const auto summary = metrics.get(phase::model_scoring);
+    assert_equal(3u, summary.count, SPOT);
+    assert_equal(0.5, summary.min_seconds, SPOT);
+    assert_equal(4.5, summary.total_seconds, SPOT);
+    metrics.merge(metrics);
+    assert_equal(3u, metrics.get(phase::model_scoring).count, SPOT);
+}
+
+TEST(test_reset) {
+    densitas::metrics metrics;
+    metrics.record(phase::quantile_extraction, 1.);
+    metrics.record(phase::model_scoring, 1, 1.);
+    metrics.reset();
+    assert_equal(0u, metrics.get(phase::quantile_extraction).count, SPOT);
+    assert_equal(0u, metrics.n_models(phase::model_scoring), SPOT);
+}
+
+TEST(test_bucket) {
+    assert_equal(0u, densitas::metrics::bucket(0.), SPOT);
+    assert_equal(0u, densitas::metrics::bucket(0.9e-6), SPOT);
+    assert_equal(1u, densitas::metrics::bucket(1e-6), SPOT);
+    assert_equal(2u, densitas::metrics::bucket(2e-6), SPOT);
+    assert_equal(10u, densitas::metrics::bucket(1e-3), SPOT);
+    assert_equal(densitas::metrics::n_buckets - 1, densitas::metrics::bucket(1e9), SPOT);
+}
+
+TEST(test_stopwatch) {
+    const densitas::core::stopwatch watch;
+    assert_true(watch.seconds() >= 0, SPOT);
+    const densitas::core::stopwatch disabled{false};
+    assert_equal(0., disabled.seconds(), SPOT);
+}
+
+}
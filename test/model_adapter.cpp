@@ -41,4 +41,41 @@ TEST(test_no) {
     assert_equal(-1, densitas::model_adapter::no<mock_model>());
 }
 
+TEST(test_save_and_load) {
+    auto model = serializable_model();
+    model.prediction = 0.25;
+    std::ostringstream stream;
+    densitas::model_adapter::save(model, stream);
+    const auto data = stream.str();
+    const auto loaded = densitas::model_adapter::load<serializable_model>(data.data(), data.size());
+    assert_equal(0.25, loaded->prediction, SPOT);
+}
+
+TEST(test_partial_train) {
+    auto model = incremental_model();
+    auto X = matrix_t(2, 2);
+    auto y = mkcol({dyes, dno});
+    densitas::model_adapter::train(model, X, y);
+    y = mkcol({dyes, dyes});
+    densitas::model_adapter::partial_train(model, X, y);
+    assert_equal(3u, model.n_yes, SPOT);
+    assert_equal(4u, model.n_events, SPOT);
+}
+
+TEST(test_partial_train_not_supported) {
+    auto model = mock_model();
+    auto X = matrix_t(1, 2);
+    auto y = mkcol({dyes});
+    assert_throw<densitas::densitas_error>([&]() { densitas::model_adapter::partial_train(model, X, y); }, SPOT);
+}
+
+struct const_model {
+    void train(const matrix_t&, vector_t&) {}
+};
+
+TEST(test_mutates_features) {
+    static_assert(densitas::model_adapter::mutates_features<mock_model, matrix_t, vector_t>::value, "");
+    static_assert(!densitas::model_adapter::mutates_features<const_model, matrix_t, vector_t>::value, "");
+}
+
 }
@@ -0,0 +1,99 @@
+#include "utils.hpp"
+
+
+COLLECTION(serialization) {
+
+TEST(test_write_and_read) {
+    std::ostringstream stream;
+    densitas::core::binary_writer writer(stream);
+    writer.write_value(std::uint32_t{42});
+    writer.align(8);
+    assert_equal(8u, writer.offset(), SPOT);
+    writer.write_value(2.5);
+    writer.write("abc", 3);
+    const auto data = stream.str();
+    assert_equal(19u, data.size(), SPOT);
+    densitas::core::binary_reader reader(data.data(), data.size());
+    assert_equal(42u, reader.read_value<std::uint32_t>(), SPOT);
+    reader.align(8);
+    assert_equal(2.5, reader.read_value<double>(), SPOT);
+    assert_equal("abc", std::string(reader.read(3), 3), SPOT);
+    assert_equal(19u, reader.offset(), SPOT);
+}
+
+TEST(test_read_past_end) {
+    const char data[] = {1, 2, 3};
+    densitas::core::binary_reader reader(data, 3);
+    reader.read(2);
+    assert_throw<densitas::densitas_error>([&]() { reader.read(2); }, SPOT);
+    assert_throw<densitas::densitas_error>([&]() { reader.align(8); }, SPOT);
+}
+
+TEST(test_header) {
+    std::ostringstream stream;
+    densitas::core::binary_writer writer(stream);
+    densitas::core::write_header(writer, sizeof(double));
+    const auto data = stream.str();
+    densitas::core::binary_reader reader(data.data(), data.size());
+    const auto version = densitas::core::read_header(reader, sizeof(double));
+    assert_equal(densitas::core::serialization_format_version, version, SPOT);
+    assert_equal(data.size(), reader.offset(), SPOT);
+}
+
+TEST(test_header_with_other_element_size) {
+    std::ostringstream stream;
+    densitas::core::binary_writer writer(stream);
+    densitas::core::write_header(writer, sizeof(float));
+    const auto data = stream.str();
+    densitas::core::binary_reader reader(data.data(), data.size());
+    assert_throw<densitas::densitas_error>([&]() { densitas::core::read_header(reader, sizeof(double)); }, SPOT);
+}
+
+std::string make_header_with_version(std::uint32_t version)
+{
+    std::ostringstream stream;
+    densitas::core::binary_writer writer(stream);
+    densitas::core::write_header(writer, sizeof(double));
+    auto data = stream.str();
+    std::memcpy(&data[8], &version, sizeof(version));
+    return data;
+}
+
+TEST(test_header_with_newer_version) {
+    const auto data = make_header_with_version(densitas::core::serialization_format_version + 1);
+    densitas::core::binary_reader reader(data.data(), data.size());
+    assert_throw<densitas::densitas_error>([&]() { densitas::core::read_header(reader, sizeof(double)); }, SPOT);
+}
+
+TEST(test_header_with_older_version) {
+    const auto data = make_header_with_version(1);
+    densitas::core::binary_reader reader(data.data(), data.size());
+    assert_equal(1u, densitas::core::read_header(reader, sizeof(double)), SPOT);
+}
+
+TEST(test_header_with_version_zero) {
+    const auto data = make_header_with_version(0);
+    densitas::core::binary_reader reader(data.data(), data.size());
+    assert_throw<densitas::densitas_error>([&]() { densitas::core::read_header(reader, sizeof(double)); }, SPOT);
+}
+
+TEST(test_mapped_file) {
+    const std::string filename = "densitas_test_mapped_file.bin";
+    {
+        std::ofstream file(filename, std::ios::binary);
+        file << "densitas";
+    }
+    {
+        densitas::core::mapped_file mapped(filename);
+        assert_equal(8u, mapped.size(), SPOT);
+        assert_equal("densitas", std::string(mapped.data(), mapped.size()), SPOT);
+        assert_equal(0u, reinterpret_cast<std::uintptr_t>(mapped.data()) % 64, SPOT);
+    }
+    std::remove(filename.c_str());
+}
+
+TEST(test_mapped_file_nonexistent) {
+    assert_throw<densitas::densitas_error>([]() { densitas::core::mapped_file("densitas_no_such_file.bin"); }, SPOT);
+}
+
+}
@@ -0,0 +1,145 @@
+#include "utils.hpp"
+#include <cmath>
+
+
+namespace {
+
+template<typename ElementType>
+std::vector<ElementType> make_values(std::size_t n)
+{
+    std::vector<ElementType> values(n);
+    for (std::size_t i=0; i<n; ++i) {
+        values[i] = static_cast<ElementType>(std::sin(0.7 * i + 0.3) * 10.);
+    }
+    return values;
+}
+
+std::vector<densitas::simd::instruction_set> instruction_sets()
+{
+    const auto supported = densitas::simd::supported_instruction_set();
+    std::vector<densitas::simd::instruction_set> sets = {densitas::simd::instruction_set::scalar};
+    for (auto set : {densitas::simd::instruction_set::sse2, densitas::simd::instruction_set::avx2, densitas::simd::instruction_set::avx512}) {
+        if (!(set > supported))
+            sets.push_back(set);
+    }
+    return sets;
+}
+
+// runs the functor with every instruction set supported and resets the active one afterwards
+template<typename Functor>
+void for_each_instruction_set(Functor&& functor)
+{
+    const auto active = densitas::simd::active_instruction_set();
+    for (auto set : instruction_sets()) {
+        assert_true(densitas::simd::use_instruction_set(set) == set, SPOT);
+        functor();
+    }
+    densitas::simd::use_instruction_set(active);
+}
+
+const std::size_t max_size = 70;
+
+}
+
+
+COLLECTION(simd) {
+
+TEST(test_use_unsupported_instruction_set) {
+    const auto active = densitas::simd::active_instruction_set();
+    const auto set = densitas::simd::use_instruction_set(densitas::simd::instruction_set::avx512);
+    assert_true(set == densitas::simd::supported_instruction_set(), SPOT);
+    assert_true(densitas::simd::active_instruction_set() == set, SPOT);
+    densitas::simd::use_instruction_set(active);
+}
+
+TEST(test_minimum) {
+    for_each_instruction_set([]() {
+        for (std::size_t n=0; n<max_size; ++n) {
+            const auto values = make_values<double>(n);
+            assert_equal(densitas::simd::scalar::minimum(values.data(), n), densitas::simd::minimum(values.data(), n), SPOT);
+            const auto float_values = make_values<float>(n);
+            assert_equal(densitas::simd::scalar::minimum(float_values.data(), n), densitas::simd::minimum(float_values.data(), n), SPOT);
+        }
+    });
+}
+
+TEST(test_minimum_ignores_nan) {
+    for_each_instruction_set([]() {
+        auto values = make_values<double>(max_size);
+        values[3] = std::numeric_limits<double>::quiet_NaN();
+        values[max_size - 1] = std::numeric_limits<double>::quiet_NaN();
+        const auto minimum = densitas::simd::minimum(values.data(), max_size);
+        values.erase(values.begin() + 3);
+        values.pop_back();
+        assert_equal(*std::min_element(values.begin(), values.end()), minimum, SPOT);
+    });
+}
+
+TEST(test_positive_sum) {
+    for_each_instruction_set([]() {
+        for (std::size_t n=0; n<max_size; ++n) {
+            const auto values = make_values<double>(n);
+            assert_equal(densitas::simd::scalar::positive_sum(values.data(), n), densitas::simd::positive_sum(values.data(), n), SPOT);
+            const auto float_values = make_values<float>(n);
+            assert_equal(densitas::simd::scalar::positive_sum(float_values.data(), n), densitas::simd::positive_sum(float_values.data(), n), SPOT);
+        }
+    });
+}
+
+TEST(test_positive_sum_happy_path) {
+    const std::vector<double> values = {1, -2, 3, 0.5};
+    assert_equal(4.5, densitas::simd::positive_sum(values.data(), values.size()), SPOT);
+}
+
+TEST(test_classification_target) {
+    for_each_instruction_set([]() {
+        for (std::size_t n=0; n<max_size; ++n) {
+            auto values = make_values<double>(n);
+            if (n > 5) values[5] = std::numeric_limits<double>::quiet_NaN();
+            std::vector<double> expected(n), actual(n);
+            densitas::simd::scalar::classification_target(values.data(), n, -2., 5., dyes, dno, expected.data());
+            densitas::simd::classification_target(values.data(), n, -2., 5., dyes, dno, actual.data());
+            assert_equal_containers(expected, actual, SPOT);
+            const auto float_values = make_values<float>(n);
+            std::vector<float> float_expected(n), float_actual(n);
+            densitas::simd::scalar::classification_target(float_values.data(), n, -2.f, 5.f, 1.f, 0.f, float_expected.data());
+            densitas::simd::classification_target(float_values.data(), n, -2.f, 5.f, 1.f, 0.f, float_actual.data());
+            assert_equal_containers(float_expected, float_actual, SPOT);
+        }
+    });
+}
+
+TEST(test_linspace) {
+    for_each_instruction_set([]() {
+        for (std::size_t n=0; n<max_size; ++n) {
+            std::vector<double> expected(n), actual(n);
+            densitas::simd::scalar::linspace(-1.5, 0.1, n, expected.data());
+            densitas::simd::linspace(-1.5, 0.1, n, actual.data());
+            assert_equal_containers(expected, actual, SPOT);
+            std::vector<float> float_expected(n), float_actual(n);
+            densitas::simd::scalar::linspace(-1.5f, 0.1f, n, float_expected.data());
+            densitas::simd::linspace(-1.5f, 0.1f, n, float_actual.data());
+            assert_equal_containers(float_expected, float_actual, SPOT);
+        }
+    });
+}
+
+TEST(test_counts) {
+    for_each_instruction_set([]() {
+        for (std::size_t n=0; n<max_size; ++n) {
+            auto values = make_values<double>(n);
+            for (auto& value : values) value = std::abs(value);
+            std::vector<std::size_t> expected(n), actual(n);
+            densitas::simd::scalar::counts(values.data(), n, 0.3, expected.data());
+            densitas::simd::counts(values.data(), n, 0.3, actual.data());
+            assert_equal_containers(expected, actual, SPOT);
+            auto float_values = make_values<float>(n);
+            for (auto& value : float_values) value = std::abs(value);
+            densitas::simd::scalar::counts(float_values.data(), n, 0.3f, expected.data());
+            densitas::simd::counts(float_values.data(), n, 0.3f, actual.data());
+            assert_equal_containers(expected, actual, SPOT);
+        }
+    });
+}
+
+}
@@ -85,6 +85,34 @@ TEST(test_launch_many) {
     assert_true(func.called, SPOT);
 }
 
+TEST(test_uses_given_pool) {
+    densitas::core::thread_pool pool{1};
+    std::atomic<int> count{0};
+    {
+        densitas::core::task_manager tm{3, pool};
+        assert_equal(3u, pool.n_threads(), SPOT);
+        for (int i=0; i<10; ++i) {
+            tm.launch_new([&count]() { ++count; });
+        }
+    }
+    assert_equal(10, count.load(), SPOT);
+    assert_equal(3u, pool.n_threads(), SPOT);
+}
+
+TEST(test_destructor_waits_for_tasks) {
+    std::atomic<int> count{0};
+    {
+        tman tm(2);
+        for (int i=0; i<4; ++i) {
+            tm.launch_new([&count]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                ++count;
+            });
+        }
+    }
+    assert_equal(4, count.load(), SPOT);
+}
+
 struct cond_var_mock {
 
     bool called;
@@ -133,6 +161,193 @@ TEST_FIXTURE(fixture, test_with_multiple_args) {
 
 }
 
+COLLECTION(thread_pool) {
+
+TEST(test_construct) {
+    densitas::core::thread_pool pool{3};
+    assert_equal(3u, pool.n_threads(), SPOT);
+}
+
+TEST(test_construct_without_threads) {
+    densitas::core::thread_pool pool;
+    assert_equal(0u, pool.n_threads(), SPOT);
+}
+
+TEST(test_reserve) {
+    densitas::core::thread_pool pool{2};
+    pool.reserve(1);
+    assert_equal(2u, pool.n_threads(), SPOT);
+    pool.reserve(4);
+    assert_equal(4u, pool.n_threads(), SPOT);
+}
+
+TEST(test_push) {
+    std::atomic<int> count{0};
+    {
+        densitas::core::thread_pool pool{2};
+        for (int i=0; i<5; ++i) {
+            pool.push([&count]() { ++count; });
+        }
+    }
+    assert_equal(5, count.load(), SPOT);
+}
+
+TEST(test_default_thread_pool) {
+    auto& pool = densitas::core::default_thread_pool();
+    assert_equal(&pool, &densitas::core::default_thread_pool(), SPOT);
+    tman tm(2);
+    assert_greater_equal(pool.n_threads(), 2u, SPOT);
+}
+
+TEST(test_async_thread_pool) {
+    auto& pool = densitas::core::async_thread_pool();
+    assert_equal(&pool, &densitas::core::async_thread_pool(), SPOT);
+    assert_true(&pool != &densitas::core::default_thread_pool(), SPOT);
+    assert_greater_equal(pool.n_threads(), 1u, SPOT);
+}
+
+}
+
+COLLECTION(launch_async) {
+
+TEST(test_result) {
+    densitas::core::thread_pool pool;
+    auto future = densitas::core::launch_async(pool, []() { return 42; });
+    assert_equal(42, future.get(), SPOT);
+    assert_equal(1u, pool.n_threads(), SPOT);
+}
+
+TEST(test_exception) {
+    densitas::core::thread_pool pool{1};
+    auto future = densitas::core::launch_async(pool, []() { throw densitas::densitas_error("failed"); });
+    assert_throw<densitas::densitas_error>([&future]() { future.get(); }, SPOT);
+}
+
+TEST(test_rejects_default_thread_pool) {
+    assert_throw<densitas::densitas_error>([]() {
+        densitas::core::launch_async(densitas::core::default_thread_pool(), []() {});
+    }, SPOT);
+}
+
+TEST(test_nested_parallel_for) {
+    densitas::core::thread_pool pool{1};
+    std::vector<std::future<std::size_t>> futures;
+    for (int i=0; i<4; ++i) {
+        futures.push_back(densitas::core::launch_async(pool, []() {
+            std::atomic<std::size_t> count{0};
+            densitas::core::parallel_for(100, 4, [&count](std::size_t, std::size_t begin, std::size_t end) {
+                count += end - begin;
+            });
+            return count.load();
+        }));
+    }
+    for (auto& future : futures) {
+        assert_equal(100u, future.get(), SPOT);
+    }
+}
+
+}
+
+COLLECTION(range_dispenser) {
+
+std::vector<densitas::core::index_range> dispense(std::size_t n_items, std::size_t n_workers)
+{
+    densitas::core::range_dispenser dispenser{n_items, n_workers};
+    std::vector<densitas::core::index_range> ranges;
+    densitas::core::index_range range{0, 0};
+    while (dispenser.next(range)) {
+        ranges.push_back(range);
+    }
+    return ranges;
+}
+
+TEST(test_ranges_are_contiguous_and_complete) {
+    const auto ranges = dispense(100, 4);
+    assert_greater(ranges.size(), 4u, SPOT);
+    std::size_t position = 0;
+    for (const auto& range : ranges) {
+        assert_equal(position, range.begin, SPOT);
+        assert_greater(range.end, range.begin, SPOT);
+        position = range.end;
+    }
+    assert_equal(100u, position, SPOT);
+}
+
+TEST(test_ranges_are_shrinking) {
+    const auto ranges = dispense(1000, 2);
+    assert_equal(250u, ranges.front().end - ranges.front().begin, SPOT);
+    assert_equal(1u, ranges.back().end - ranges.back().begin, SPOT);
+}
+
+TEST(test_no_items) {
+    assert_equal(0u, dispense(0, 3).size(), SPOT);
+}
+
+TEST(test_stop) {
+    densitas::core::range_dispenser dispenser{10, 1};
+    densitas::core::index_range range{0, 0};
+    assert_true(dispenser.next(range), SPOT);
+    dispenser.stop();
+    assert_false(dispenser.next(range), SPOT);
+}
+
+}
+
+COLLECTION(parallel_for) {
+
+void make_test_visits_all(int threads)
+{
+    const std::size_t n_items = 1000;
+    std::vector<int> visits(n_items, 0);
+    densitas::core::parallel_for(n_items, threads, [&visits](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i=begin; i<end; ++i) {
+            ++visits[i];
+        }
+    });
+    for (const auto visit : visits) {
+        assert_equal(1, visit, SPOT);
+    }
+}
+
+TEST(test_visits_all) {
+    make_test_visits_all(1);
+}
+
+TEST(test_visits_all_async) {
+    make_test_visits_all(4);
+}
+
+TEST(test_single_threaded_is_one_range) {
+    std::size_t calls = 0;
+    densitas::core::parallel_for(10, 1, [&calls](std::size_t worker, std::size_t begin, std::size_t end) {
+        assert_equal(0u, worker, SPOT);
+        assert_equal(0u, begin, SPOT);
+        assert_equal(10u, end, SPOT);
+        ++calls;
+    });
+    assert_equal(1u, calls, SPOT);
+}
+
+TEST(test_worker_indices) {
+    std::atomic<std::size_t> max_worker{0};
+    densitas::core::parallel_for(300, 3, [&max_worker](std::size_t worker, std::size_t, std::size_t) {
+        auto current = max_worker.load();
+        while (worker > current && !max_worker.compare_exchange_weak(current, worker));
+    });
+    assert_lesser(max_worker.load(), 3u, SPOT);
+}
+
+TEST(test_exception_is_rethrown) {
+    assert_throw<densitas::densitas_error>([]() {
+        densitas::core::parallel_for(100, 4, [](std::size_t, std::size_t begin, std::size_t end) {
+            if (begin <= 50 && 50 < end)
+                throw densitas::densitas_error("failed");
+        });
+    }, SPOT);
+}
+
+}
+
 struct cv : densitas::core::condition_variable {
 
     bool get_flag()
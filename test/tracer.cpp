@@ -0,0 +1,82 @@
+#include "utils.hpp"
+
+
+COLLECTION(tracer) {
+
+TEST(test_record) {
+    densitas::tracer tracer;
+    assert_equal(0u, tracer.n_events(), SPOT);
+    tracer.record("task", "train", 1., 3.5, {{"model", 2}});
+    assert_equal(1u, tracer.n_events(), SPOT);
+    std::ostringstream stream;
+    tracer.write(stream);
+    const auto json = stream.str();
+    assert_true(json.find("\"traceEvents\":[") != std::string::npos, SPOT);
+    assert_true(json.find("{\"name\":\"task\",\"cat\":\"train\",\"ph\":\"X\",\"ts\":1.000,\"dur\":2.500,\"pid\":1,\"tid\":0,\"args\":{\"model\":2}}") != std::string::npos, SPOT);
+    assert_true(json.find("\"thread_name\"") != std::string::npos, SPOT);
+}
+
+TEST(test_write_empty) {
+    densitas::tracer tracer;
+    std::ostringstream stream;
+    tracer.write(stream);
+    assert_equal("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n", stream.str(), SPOT);
+}
+
+TEST(test_write_escapes_strings) {
+    densitas::tracer tracer;
+    tracer.record("a \"quoted\"\\name\n", "cat", 0., 1.);
+    std::ostringstream stream;
+    tracer.write(stream);
+    assert_true(stream.str().find("\"a \\\"quoted\\\"\\\\name\\n\"") != std::string::npos, SPOT);
+}
+
+TEST(test_threads) {
+    densitas::tracer tracer;
+    tracer.record("main", "cat", 0., 1.);
+    std::thread thread([&tracer]() { tracer.record("other", "cat", 0., 1.); });
+    thread.join();
+    tracer.record("main", "cat", 1., 2.);
+    std::ostringstream stream;
+    tracer.write(stream);
+    const auto json = stream.str();
+    assert_true(json.find("\"name\":\"other\",\"cat\":\"cat\",\"ph\":\"X\",\"ts\":0.000,\"dur\":1.000,\"pid\":1,\"tid\":1") != std::string::npos, SPOT);
+    assert_true(json.find("\"name\":\"main\",\"cat\":\"cat\",\"ph\":\"X\",\"ts\":1.000,\"dur\":1.000,\"pid\":1,\"tid\":0") != std::string::npos, SPOT);
+}
+
+TEST(test_clear) {
+    densitas::tracer tracer;
+    tracer.record("task", "train", 0., 1.);
+    tracer.clear();
+    assert_equal(0u, tracer.n_events(), SPOT);
+}
+
+TEST(test_save) {
+    const std::string filename = "densitas_test_trace.json";
+    densitas::tracer tracer;
+    tracer.record("task", "train", 0., 1.);
+    tracer.save(filename);
+    std::ifstream file(filename);
+    const std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    std::remove(filename.c_str());
+    std::ostringstream stream;
+    tracer.write(stream);
+    assert_equal(stream.str(), contents, SPOT);
+}
+
+TEST(test_trace_scope) {
+    densitas::tracer tracer;
+    {
+        const densitas::core::trace_scope scope{&tracer, "scope", "cat", {{"index", 3}}};
+    }
+    assert_equal(1u, tracer.n_events(), SPOT);
+    std::ostringstream stream;
+    tracer.write(stream);
+    assert_true(stream.str().find("\"args\":{\"index\":3}") != std::string::npos, SPOT);
+}
+
+TEST(test_trace_scope_without_tracer) {
+    const densitas::core::trace_scope scope{nullptr, "scope", "cat"};
+}
+
+}
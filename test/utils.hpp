@@ -10,6 +10,10 @@ typedef arma::vec vector_t;
 
 typedef arma::mat matrix_t;
 
+typedef arma::fvec float_vector_t;
+
+typedef arma::fmat float_matrix_t;
+
 
 inline
 vector_t mkcol(std::vector<double> data)
@@ -62,6 +66,264 @@ struct mock_model {
 };
 
 
+// a model predicting the probability of 'yes' from the distances of the
+// first feature to its means over the 'yes' and 'no' events
+template<typename VectorType, typename MatrixType, typename ElementType>
+struct nearest_mean_model {
+
+    ElementType mean_yes;
+    ElementType mean_no;
+
+    nearest_mean_model()
+        : mean_yes(0), mean_no(0)
+    {}
+
+    std::unique_ptr<nearest_mean_model> clone() const
+    {
+        return std::unique_ptr<nearest_mean_model>(new nearest_mean_model(*this));
+    }
+
+    void train(const MatrixType& X, VectorType& y)
+    {
+        const auto yes = densitas::model_adapter::yes<nearest_mean_model>();
+        ElementType sum_yes = 0, sum_no = 0;
+        std::size_t n_yes = 0;
+        for (std::size_t i=0; i<y.n_elem; ++i) {
+            if (y(i) == yes) {
+                sum_yes += X(i, 0);
+                ++n_yes;
+            } else {
+                sum_no += X(i, 0);
+            }
+        }
+        mean_yes = sum_yes / std::max<std::size_t>(n_yes, 1);
+        mean_no = sum_no / std::max<std::size_t>(y.n_elem - n_yes, 1);
+    }
+
+    VectorType predict_proba(MatrixType& X) const
+    {
+        VectorType probas(X.n_rows);
+        for (std::size_t i=0; i<X.n_rows; ++i) {
+            const auto distance = std::abs(X(i, 0) - mean_yes) - std::abs(X(i, 0) - mean_no);
+            probas(i) = 1 / (1 + std::exp(distance));
+        }
+        return probas;
+    }
+
+};
+
+// deterministic regression data of 200 events and two features
+template<typename VectorType, typename MatrixType>
+void make_typed_data(MatrixType& X, VectorType& y)
+{
+    const std::size_t n_rows = 200;
+    X = MatrixType(n_rows, 2);
+    y = VectorType(n_rows);
+    for (std::size_t i=0; i<n_rows; ++i) {
+        const auto x = std::sin(0.1 * i) * 3;
+        X(i, 0) = static_cast<typename VectorType::elem_type>(x);
+        X(i, 1) = static_cast<typename VectorType::elem_type>(std::cos(0.3 * i));
+        y(i) = static_cast<typename VectorType::elem_type>(2 * x + std::cos(0.7 * i));
+    }
+}
+
+// a model that predicts the fraction of 'yes' seen in training and can be
+// saved and loaded
+struct serializable_model {
+
+    double prediction;
+
+    serializable_model()
+        : prediction(0)
+    {}
+
+    std::unique_ptr<serializable_model> clone() const
+    {
+        return std::unique_ptr<serializable_model>(new serializable_model(*this));
+    }
+
+    void train(const matrix_t&, vector_t& y)
+    {
+        const auto yes = densitas::model_adapter::yes<serializable_model>();
+        prediction = static_cast<double>(std::count(y.begin(), y.end(), yes)) / y.n_elem;
+    }
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        vector_t probas(X.n_rows);
+        std::fill(probas.begin(), probas.end(), prediction);
+        return probas;
+    }
+
+    void save(std::ostream& stream) const
+    {
+        stream.write(reinterpret_cast<const char*>(&prediction), sizeof(prediction));
+    }
+
+    static std::unique_ptr<serializable_model> load(const char* data, std::size_t size)
+    {
+        if (size != sizeof(double))
+            throw densitas::densitas_error("invalid model size");
+        std::unique_ptr<serializable_model> model(new serializable_model);
+        std::memcpy(&model->prediction, data, sizeof(double));
+        return model;
+    }
+
+};
+
+
+// a model that predicts the fraction of 'yes' seen in training and can be
+// trained incrementally
+struct incremental_model {
+
+    std::size_t n_yes;
+    std::size_t n_events;
+
+    incremental_model()
+        : n_yes(0), n_events(0)
+    {}
+
+    std::unique_ptr<incremental_model> clone() const
+    {
+        return std::unique_ptr<incremental_model>(new incremental_model(*this));
+    }
+
+    void train(const matrix_t& X, vector_t& y)
+    {
+        n_yes = 0;
+        n_events = 0;
+        partial_train(X, y);
+    }
+
+    void partial_train(const matrix_t&, vector_t& y)
+    {
+        const auto yes = densitas::model_adapter::yes<incremental_model>();
+        n_yes += static_cast<std::size_t>(std::count(y.begin(), y.end(), yes));
+        n_events += y.n_elem;
+    }
+
+    vector_t predict_proba(matrix_t& X) const
+    {
+        vector_t probas(X.n_rows);
+        std::fill(probas.begin(), probas.end(), static_cast<double>(n_yes) / n_events);
+        return probas;
+    }
+
+    void save(std::ostream& stream) const
+    {
+        const std::uint64_t counts[2] = {n_yes, n_events};
+        stream.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+    }
+
+    static std::unique_ptr<incremental_model> load(const char* data, std::size_t size)
+    {
+        std::uint64_t counts[2];
+        if (size != sizeof(counts))
+            throw densitas::densitas_error("invalid model size");
+        std::memcpy(counts, data, sizeof(counts));
+        std::unique_ptr<incremental_model> model(new incremental_model);
+        model->n_yes = static_cast<std::size_t>(counts[0]);
+        model->n_events = static_cast<std::size_t>(counts[1]);
+        return model;
+    }
+
+};
+
+
+// a vector and a matrix providing element access only so that the adapters
+// cannot access their memory directly
+class plain_vector {
+public:
+
+    explicit
+    plain_vector(std::size_t size)
+        : data_(size)
+    {}
+
+    explicit
+    plain_vector(const vector_t& vector)
+        : data_(vector.begin(), vector.end())
+    {}
+
+    std::size_t size() const
+    {
+        return data_.size();
+    }
+
+    double operator()(std::size_t index) const
+    {
+        return data_[index];
+    }
+
+    double& operator()(std::size_t index)
+    {
+        return data_[index];
+    }
+
+    vector_t to_vector() const
+    {
+        vector_t vector(data_.size());
+        std::copy(data_.begin(), data_.end(), vector.begin());
+        return vector;
+    }
+
+private:
+    std::vector<double> data_;
+};
+
+
+class plain_matrix {
+public:
+
+    plain_matrix(std::size_t n_rows, std::size_t n_cols)
+        : n_rows_(n_rows), n_cols_(n_cols), data_(n_rows * n_cols)
+    {}
+
+    explicit
+    plain_matrix(const matrix_t& matrix)
+        : n_rows_(matrix.n_rows), n_cols_(matrix.n_cols), data_(matrix.n_rows * matrix.n_cols)
+    {
+        for (std::size_t i=0; i<n_rows_; ++i)
+            for (std::size_t j=0; j<n_cols_; ++j)
+                (*this)(i, j) = matrix(i, j);
+    }
+
+    std::size_t n_rows() const
+    {
+        return n_rows_;
+    }
+
+    std::size_t n_cols() const
+    {
+        return n_cols_;
+    }
+
+    double operator()(std::size_t i, std::size_t j) const
+    {
+        return data_[i * n_cols_ + j];
+    }
+
+    double& operator()(std::size_t i, std::size_t j)
+    {
+        return data_[i * n_cols_ + j];
+    }
+
+    matrix_t to_matrix() const
+    {
+        matrix_t matrix(n_rows_, n_cols_);
+        for (std::size_t i=0; i<n_rows_; ++i)
+            for (std::size_t j=0; j<n_cols_; ++j)
+                matrix(i, j) = (*this)(i, j);
+        return matrix;
+    }
+
+private:
+    std::size_t n_rows_;
+    std::size_t n_cols_;
+    std::vector<double> data_;
+};
+
+
 const int no = densitas::model_adapter::no<mock_model>();
 
 const int yes = densitas::model_adapter::yes<mock_model>();
@@ -88,6 +350,26 @@ std::size_t n_columns(const matrix_t& matrix)
     return matrix.n_cols;
 }
 
+template<>
+inline
+std::size_t n_rows(const float_matrix_t& matrix)
+{
+    return matrix.n_rows;
+}
+
+template<>
+inline
+std::size_t n_columns(const float_matrix_t& matrix)
+{
+    return matrix.n_cols;
+}
+
+template<>
+struct column_major_memptr<matrix_t> : std::true_type {};
+
+template<>
+struct column_major_memptr<float_matrix_t> : std::true_type {};
+
 } // matrix_adapter
 
 namespace vector_adapter {
@@ -99,6 +381,19 @@ std::size_t n_elements(const vector_t& vector)
     return vector.n_elem;
 }
 
+template<>
+inline
+std::size_t n_elements(const float_vector_t& vector)
+{
+    return vector.n_elem;
+}
+
+template<>
+struct contiguous_memory<vector_t> : std::true_type {};
+
+template<>
+struct contiguous_memory<float_vector_t> : std::true_type {};
+
 } // vector_adapter
 } // densitas
 
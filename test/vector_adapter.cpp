@@ -32,6 +32,27 @@ public:
 };
 
 
+// a contiguous vector exposing its memory through data()
+struct data_vector {
+    std::vector<double> values;
+
+    const double* data() const
+    {
+        return values.data();
+    }
+};
+
+
+namespace densitas {
+namespace vector_adapter {
+
+template<>
+struct contiguous_memory<data_vector> : std::true_type {};
+
+} // vector_adapter
+} // densitas
+
+
 COLLECTION(vector_adapter) {
 
 TEST(test_construct_uninitialized) {
@@ -65,4 +86,52 @@ TEST(test_set_element) {
     assert_equal(index, vector.index_used_, SPOT);
 }
 
+TEST(test_data_without_contiguous_memory) {
+    const mock_vector vector(3);
+    assert_true(densitas::vector_adapter::data<double>(vector) == nullptr, SPOT);
+}
+
+TEST(test_data_with_memptr) {
+    const auto vector = mkcol({1, 2, 3});
+    assert_equal(vector.memptr(), densitas::vector_adapter::data<double>(vector), SPOT);
+}
+
+TEST(test_data_with_data_method) {
+    const data_vector vector{{1, 2, 3}};
+    assert_equal(vector.data(), densitas::vector_adapter::data<double>(vector), SPOT);
+}
+
+TEST(test_data_with_other_element_type) {
+    const float_vector_t vector(3);
+    assert_true(densitas::vector_adapter::data<double>(vector) == nullptr, SPOT);
+}
+
+TEST(test_data_without_contiguous_memory_declared) {
+    const std::vector<double> vector = {1, 2, 3};
+    assert_false(densitas::vector_adapter::contiguous_memory<std::vector<double>>::value, SPOT);
+    assert_true(densitas::vector_adapter::data<double>(vector) == nullptr, SPOT);
+}
+
+TEST(test_construct_from_memory) {
+    const double data[] = {1, 2, 3};
+    const auto vector = densitas::vector_adapter::construct_from_memory<vector_t>(data, 3);
+    assert_equal_containers(mkcol({1, 2, 3}), vector, SPOT);
+    assert_true(vector.memptr() != data, SPOT);
+}
+
+TEST(test_construct_from_memory_without_contiguous_memory) {
+    const double data[] = {1, 2, 3};
+    const auto vector = densitas::vector_adapter::construct_from_memory<mock_vector>(data, 3);
+    assert_equal(3u, vector.size_, SPOT);
+    assert_equal(3, vector.value_, SPOT);
+    assert_equal(2u, vector.index_used_, SPOT);
+}
+
+TEST(test_mutable_data) {
+    auto vector = mkcol({1, 2, 3});
+    const auto data = densitas::vector_adapter::mutable_data<double>(vector);
+    assert_equal(vector.memptr(), data, SPOT);
+    data[1] = 4;
+    assert_equal(4, vector(1), SPOT);
+}
 }